@@ -0,0 +1,15 @@
+######################################################################
+# Headless grading of answer sheets against a dictionary.
+######################################################################
+
+TEMPLATE = app
+TARGET = batchgrader
+CONFIG += console
+CONFIG -= qt app_bundle
+DEPENDPATH += .
+INCLUDEPATH += .
+
+include(backend.pri)
+
+# Input
+SOURCES += batchgrader.cpp
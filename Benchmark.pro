@@ -0,0 +1,15 @@
+######################################################################
+# Microbenchmarks for the backend's parsing, lookup and profile I/O.
+######################################################################
+
+TEMPLATE = app
+TARGET = benchmark
+CONFIG += console release
+CONFIG -= qt app_bundle debug
+DEPENDPATH += .
+INCLUDEPATH += .
+
+include(backend.pri)
+
+# Input
+SOURCES += benchmark.cpp
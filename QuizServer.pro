@@ -0,0 +1,15 @@
+######################################################################
+# Headless quiz server for many learners sharing one machine.
+######################################################################
+
+TEMPLATE = app
+TARGET = quizserver
+CONFIG += console
+CONFIG -= qt app_bundle
+DEPENDPATH += .
+INCLUDEPATH += .
+
+include(backend.pri)
+
+# Input
+SOURCES += quizserver.cpp
@@ -0,0 +1,13 @@
+######################################################################
+# Checks the quiz server's replies to requests made out of order.
+######################################################################
+
+TEMPLATE = app
+TARGET = quizservertest
+CONFIG += console
+CONFIG -= qt app_bundle
+DEPENDPATH += .
+INCLUDEPATH += .
+
+# Input
+SOURCES += quizservertest.cpp
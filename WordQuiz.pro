@@ -7,32 +7,20 @@ TARGET =
 DEPENDPATH += .
 INCLUDEPATH += .
 
+include(backend.pri)
+
 # Input
-HEADERS += connection.hpp \
-           exceptions.hpp \
-           languagedialog.hpp \
-           languagepair.hpp \
+HEADERS += languagedialog.hpp \
            logindialog.hpp \
            mainwindow.hpp \
            menudialog.hpp \
            newprofiledialog.hpp \
-           profilemanager.hpp \
-           quizdialog.hpp \
-           quizlist.hpp \
-           userprofile.hpp \
-           util_global.hpp \
-           vocabquiz.hpp
-SOURCES += connection.cpp \
-           languagedialog.cpp \
-           languagepair.cpp \
+           quizdialog.hpp
+SOURCES += languagedialog.cpp \
            logindialog.cpp \
            main.cpp \
            mainwindow.cpp \
            menudialog.cpp \
            newprofiledialog.cpp \
-           profilemanager.cpp \
-           quizdialog.cpp \
-           quizlist.cpp \
-           userprofile.cpp \
-           vocabquiz.cpp
+           quizdialog.cpp
 RESOURCES += wordquiz.qrc
@@ -0,0 +1,321 @@
+/**
+ * @file answerjournal.cpp
+ * @brief Records quiz answers without rewriting the whole profile.
+ * @author Alex Zirbel
+ *
+ * Saving a profile rewrites every word in it, which is far too much work to
+ * do after every answer. Instead, each answer appends one line to a journal
+ * file next to the profile, holding the new proficiency and quiz time of the
+ * word that was asked:
+ *
+ *   <lang1>\t<lang2>\t<word1>\t<word2>\t<proficiency>\t<lastquizzed>
+ *
+ * When a profile is loaded, its journal is replayed on top of it. Answers
+ * for lists still waiting in the binary profile file are kept with the list
+ * rather than loading it, and applied when it is first requested. Once the
+ * journal grows past JOURNAL_COMPACT_THRESHOLD records, it is compacted: the
+ * journal is set aside, a snapshot of the profile is saved on a background
+ * thread, and the old journal is deleted once the save has finished. The
+ * profile file is replaced in one step, so it always holds either the old
+ * profile or the new one. If the
+ * program stops before then, the set-aside journal is replayed at the next
+ * load; records only ever set absolute values, so replaying them twice is
+ * harmless. If the save fails, the set-aside journal is kept, and the next
+ * compaction appends to it rather than replacing it.
+ */
+
+#include "answerjournal.hpp"
+#include "fieldscanner.hpp"
+
+#include <cstdio>
+#include <vector>
+#include <unistd.h>
+#include <boost/shared_ptr.hpp>
+
+using namespace std;
+using namespace boost;
+
+//! The number of tab-separated fields in one journal record.
+#define JOURNAL_RECORD_FIELDS 6
+
+/**
+ * Saves a snapshot of a profile on the compaction thread, then deletes the
+ * journal records which the snapshot includes.
+ */
+struct CompactionTask
+{
+    boost::shared_ptr<const ProfileSnapshot> snapshot;
+    string profileFilename;
+    string oldJournalFilename;
+
+    void operator()()
+    {
+        if(snapshot->saveBinaryProfile(profileFilename))
+            remove(oldJournalFilename.c_str());
+    }
+};
+
+
+/**
+ * Creates a journal for a profile. Nothing is recorded until open is called.
+ * @param myProfile The profile answers are recorded for
+ * @param myProfileFilename The file the profile is saved to on compaction
+ */
+AnswerJournal::AnswerJournal(UserProfile *myProfile, string myProfileFilename)
+{
+    profile = myProfile;
+    profileFilename = myProfileFilename;
+    numRecords = 0;
+}
+
+
+/**
+ * Waits for any compaction in progress, so that the profile is never left
+ * half saved.
+ */
+AnswerJournal::~AnswerJournal()
+{
+    waitForCompaction();
+}
+
+
+/**
+ * Opens the journal file for appending, creating it if necessary.
+ * @param journalFilename The full path and name of the journal
+ * @return True if the journal could be opened
+ */
+bool AnswerJournal::open(string journalFilename)
+{
+    filename = journalFilename;
+
+    // Count what is already there so compaction happens on schedule
+    numRecords = 0;
+    ifstream existing(filename.c_str());
+    string line;
+    while(getline(existing, line))
+        numRecords++;
+    existing.close();
+
+    journalFile.open(filename.c_str(), ofstream::out | ofstream::app);
+    return journalFile.is_open();
+}
+
+
+/**
+ * Appends a connection's current statistics to the journal in one write,
+ * and starts a compaction if the journal has grown too large.
+ * @param conn A connection of the profile which has just been quizzed
+ * @return True if the record was written
+ */
+bool AnswerJournal::record(Connection &conn)
+{
+    if(!journalFile.is_open())
+        return false;
+
+    string line = conn.getLang1() + "\t" + conn.getLang2() + "\t" +
+                  conn.exportToLine() + "\n";
+
+    journalFile.write(line.data(), line.size());
+    journalFile.flush();
+
+    if(journalFile.fail())
+        return false;
+
+    numRecords++;
+    if(numRecords >= JOURNAL_COMPACT_THRESHOLD)
+        compact();
+
+    return true;
+}
+
+
+/**
+ * Folds the journal into the profile file. The current journal is set aside
+ * and a fresh one is started, so answers can keep being recorded while a
+ * snapshot of the profile is saved on a background thread.
+ * @return False if a compaction is already running or the journal could not
+ *  be set aside.
+ */
+bool AnswerJournal::compact()
+{
+    if(compactor.joinable() &&
+       !compactor.timed_join(boost::posix_time::milliseconds(0)))
+        return false;
+
+    // Taken before the journal is set aside, so it includes every record.
+    // Every list is loaded while taking it, so that the compaction thread
+    // never has to load one into the shared word pool.
+    boost::shared_ptr<const ProfileSnapshot> snapshot = profile->snapshot();
+
+    string oldFilename = compactingFilename(filename);
+
+    journalFile.close();
+
+    // A journal set aside by a compaction whose save failed still holds
+    // answers the profile file lacks, so it must not be replaced
+    bool setAside;
+    ifstream unsaved(oldFilename.c_str());
+    if(unsaved.is_open())
+    {
+        unsaved.close();
+        setAside = appendFile(filename, oldFilename);
+    }
+    else
+        setAside = (rename(filename.c_str(), oldFilename.c_str()) == 0);
+
+    if(!setAside)
+    {
+        journalFile.open(filename.c_str(), ofstream::out | ofstream::app);
+        return false;
+    }
+
+    journalFile.open(filename.c_str(), ofstream::out | ofstream::trunc);
+    numRecords = 0;
+
+    CompactionTask task;
+    task.snapshot = snapshot;
+    task.profileFilename = profileFilename;
+    task.oldJournalFilename = oldFilename;
+
+    compactor = boost::thread(task);
+    return true;
+}
+
+
+/**
+ * Blocks until a compaction started by this journal has finished.
+ */
+void AnswerJournal::waitForCompaction()
+{
+    if(compactor.joinable())
+        compactor.join();
+}
+
+
+/**
+ * Applies a profile's journal to it, including records set aside by a
+ * compaction that never finished.
+ * @param journalFilename The journal of the profile
+ * @param profile A freshly loaded profile
+ * @return The number of records applied, or kept for lists not loaded yet
+ */
+int AnswerJournal::replay(string journalFilename, UserProfile *profile)
+{
+    return replayFile(compactingFilename(journalFilename), profile) +
+           replayFile(journalFilename, profile);
+}
+
+
+/**
+ * The name a journal is moved to while it is being compacted.
+ */
+string AnswerJournal::compactingFilename(string journalFilename)
+{
+    return journalFilename + ".old";
+}
+
+
+/**
+ * Appends the records of one journal file to another. A final record of the
+ * destination which was cut short is dropped first, as replay would skip it,
+ * so that it does not run into the first appended record.
+ * @param sourceFilename The journal to copy from; it is not changed
+ * @param destFilename The journal to append to
+ * @return True if every record was appended
+ */
+bool AnswerJournal::appendFile(string sourceFilename, string destFilename)
+{
+    ifstream source(sourceFilename.c_str(), ifstream::binary);
+    if(!source.is_open())
+        return false;
+
+    // Find the end of the last complete record
+    ifstream existing(destFilename.c_str(), ifstream::binary);
+    if(!existing.is_open())
+        return false;
+    existing.seekg(0, ifstream::end);
+    streamoff recordsEnd = existing.tellg();
+    char last = '\n';
+    while(recordsEnd > 0)
+    {
+        existing.seekg(recordsEnd - 1);
+        existing.get(last);
+        if(last == '\n')
+            break;
+        recordsEnd--;
+    }
+    existing.close();
+
+    if(truncate(destFilename.c_str(), (off_t) recordsEnd) != 0)
+        return false;
+
+    ofstream dest(destFilename.c_str(), ofstream::out | ofstream::app |
+                                        ofstream::binary);
+    if(!dest.is_open())
+        return false;
+
+    // Copying an empty journal sets failbit, so only copy a non-empty one
+    if(source.peek() != ifstream::traits_type::eof())
+        dest << source.rdbuf();
+    dest.flush();
+
+    return !dest.fail();
+}
+
+
+/**
+ * Applies every record of one journal file to a profile. Records for words
+ * which are no longer in the profile are skipped, as is a final record which
+ * was cut short before its newline was written.
+ */
+int AnswerJournal::replayFile(string journalFilename, UserProfile *profile)
+{
+    ifstream journal(journalFilename.c_str());
+    if(!journal.is_open())
+        return 0;
+
+    string line;
+    int applied = 0;
+
+    while(getline(journal, line))
+    {
+        if(journal.eof())
+            break;
+
+        // lang1, lang2, word1, word2, proficiency, last quizzed
+        FieldScanner scanner(line);
+        string_ref fields[JOURNAL_RECORD_FIELDS];
+        int numFields = 0;
+        while(numFields < JOURNAL_RECORD_FIELDS &&
+              scanner.next(fields[numFields]))
+            numFields++;
+        if(numFields < JOURNAL_RECORD_FIELDS)
+            continue;
+
+        int proficiency;
+        unsigned int lastQuizzed;
+        if(!parseInt(fields[4], proficiency) ||
+           !parseUnsigned(fields[5], lastQuizzed))
+            continue;
+
+        JournaledAnswer answer;
+        answer.word1 = fields[2].to_string();
+        answer.word2 = fields[3].to_string();
+        answer.proficiency = proficiency;
+        answer.lastQuizzed = (time_t) lastQuizzed;
+
+        try
+        {
+            LanguagePair languages(fields[0].to_string(),
+                                   fields[1].to_string(), 1);
+            if(profile->applyJournaledAnswer(languages, answer))
+                applied++;
+        }
+        catch(InvalidLanguageException *e)
+        {
+            delete e;
+        }
+    }
+
+    return applied;
+}
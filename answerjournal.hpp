@@ -0,0 +1,53 @@
+/**
+ * @file answerjournal.hpp
+ * @brief Header definitions for the AnswerJournal class.
+ * @author Alex Zirbel
+ */
+
+#ifndef ANSWERJOURNAL_H
+#define ANSWERJOURNAL_H
+
+#include <string>
+#include <fstream>
+#include <boost/thread/thread.hpp>
+
+#include "connection.hpp"
+#include "userprofile.hpp"
+
+//! Once a journal holds this many records, it is folded into the profile.
+#define JOURNAL_COMPACT_THRESHOLD 10000
+
+class AnswerJournal
+{
+//! The profile whose answers are recorded. Must outlive the journal.
+UserProfile *profile;
+//! Where the full profile is saved when the journal is compacted.
+std::string profileFilename;
+std::string filename;
+std::ofstream journalFile;
+
+//! Number of records in the current journal file.
+unsigned int numRecords;
+
+//! Saves a snapshot of the profile while the quiz carries on.
+boost::thread compactor;
+
+public:
+    AnswerJournal(UserProfile *myProfile, std::string myProfileFilename);
+    ~AnswerJournal();
+
+    bool open(std::string journalFilename);
+    bool record(Connection &conn);
+    bool compact();
+    void waitForCompaction();
+
+    static int replay(std::string journalFilename, UserProfile *profile);
+    static std::string compactingFilename(std::string journalFilename);
+
+private:
+    static int replayFile(std::string journalFilename, UserProfile *profile);
+    static bool appendFile(std::string sourceFilename,
+                           std::string destFilename);
+};
+
+#endif // ANSWERJOURNAL_H
@@ -0,0 +1,100 @@
+/**
+ * @file arena.cpp
+ * @brief A bump allocator for memory which is all freed at once.
+ * @author Alex Zirbel
+ *
+ * Loading a dictionary creates hundreds of thousands of small objects which
+ * all live exactly as long as the dictionary. Allocating each one from the
+ * heap costs time on the way in and on the way out, and scatters them
+ * through memory. An Arena instead takes large blocks from the heap and
+ * hands out consecutive pieces of them; nothing is freed individually, and
+ * all the blocks are released together when the arena goes away.
+ */
+
+#include "arena.hpp"
+
+using namespace std;
+
+Arena::Arena()
+{
+    next = NULL;
+    remaining = 0;
+    used = 0;
+    reserved = 0;
+}
+
+
+Arena::~Arena()
+{
+    release();
+}
+
+
+/**
+ * Hands out memory from the current block, starting a new block when it
+ * runs out.
+ * @param bytes How much memory is needed
+ * @param alignment The alignment the memory needs, a power of two
+ * @return The memory, valid until the arena is released
+ */
+void* Arena::allocate(size_t bytes, size_t alignment)
+{
+    size_t padding = (alignment - ((size_t) next & (alignment - 1))) &
+                     (alignment - 1);
+
+    if(next == NULL || padding + bytes > remaining)
+    {
+        // Oversized requests get a block of their own
+        size_t blockSize = (bytes > ARENA_BLOCK_SIZE) ? bytes : ARENA_BLOCK_SIZE;
+
+        char *block = (char*) ::operator new(blockSize);
+        blocks.push_back(block);
+        reserved += blockSize;
+
+        next = block;
+        remaining = blockSize;
+        padding = 0;
+    }
+
+    void *memory = next + padding;
+    next += padding + bytes;
+    remaining -= padding + bytes;
+    used += bytes;
+
+    return memory;
+}
+
+
+/**
+ * Returns every block to the heap at once. Anything allocated from the arena
+ * must no longer be in use.
+ */
+void Arena::release()
+{
+    for(size_t i = 0; i < blocks.size(); i++)
+        ::operator delete(blocks[i]);
+
+    blocks.clear();
+    next = NULL;
+    remaining = 0;
+    used = 0;
+    reserved = 0;
+}
+
+
+/**
+ * The number of bytes handed out since the arena was created or released.
+ */
+size_t Arena::bytesUsed() const
+{
+    return used;
+}
+
+
+/**
+ * The number of bytes taken from the heap, including unused space.
+ */
+size_t Arena::bytesReserved() const
+{
+    return reserved;
+}
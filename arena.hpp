@@ -0,0 +1,132 @@
+/**
+ * @file arena.hpp
+ * @brief Header definitions for the Arena class and its STL allocator.
+ * @author Alex Zirbel
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+//! Size of each block an arena takes from the heap.
+#define ARENA_BLOCK_SIZE (256 * 1024)
+//! Allocations larger than this bypass the arena, so that tables which are
+//! regrown (hash buckets) are really freed rather than abandoned in a block.
+#define ARENA_LARGE_ALLOCATION (ARENA_BLOCK_SIZE / 8)
+
+//! The heap rounds every allocation up to a multiple of this.
+#define HEAP_ALIGNMENT 16
+
+/**
+ * Estimates the memory a heap allocation really takes: the allocator keeps
+ * a size word in front of every block and rounds the block up.
+ * @param bytes The number of bytes asked for
+ */
+inline size_t heapBlockBytes(size_t bytes)
+{
+    return (bytes + sizeof(size_t) + HEAP_ALIGNMENT - 1) &
+           ~((size_t) HEAP_ALIGNMENT - 1);
+}
+
+class Arena : boost::noncopyable
+{
+//! Every block taken from the heap, released together.
+std::vector<char*> blocks;
+//! The unused part of the newest block.
+char *next;
+size_t remaining;
+//! Bytes handed out so far.
+size_t used;
+//! Bytes taken from the heap so far.
+size_t reserved;
+
+public:
+    Arena();
+    ~Arena();
+
+    void* allocate(size_t bytes, size_t alignment);
+    void release();
+    size_t bytesUsed() const;
+    size_t bytesReserved() const;
+};
+
+/**
+ * An STL allocator which takes its memory from an Arena. Deallocating does
+ * nothing: the memory is returned when the arena is released or destroyed,
+ * which must not happen while a container using it is still alive.
+ */
+template <typename T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <typename U> struct rebind
+    {
+        typedef ArenaAllocator<U> other;
+    };
+
+    //! The arena memory comes from. Public so that rebound copies can share it.
+    Arena *arena;
+
+    explicit ArenaAllocator(Arena *myArena) : arena(myArena) { }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) { }
+
+    pointer allocate(size_type n, const void* = 0)
+    {
+        if(n * sizeof(T) > ARENA_LARGE_ALLOCATION)
+            return (pointer) ::operator new(n * sizeof(T));
+
+        return (pointer) arena->allocate(n * sizeof(T), sizeof(void*));
+    }
+
+    void deallocate(pointer p, size_type n)
+    {
+        if(n * sizeof(T) > ARENA_LARGE_ALLOCATION)
+            ::operator delete(p);
+    }
+
+    void construct(pointer p, const T &value)
+    {
+        new ((void*) p) T(value);
+    }
+
+    void destroy(pointer p)
+    {
+        p->~T();
+    }
+
+    pointer address(reference value) const { return &value; }
+    const_pointer address(const_reference value) const { return &value; }
+
+    size_type max_size() const
+    {
+        return ((size_type) -1) / sizeof(T);
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const
+    {
+        return arena == other.arena;
+    }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const
+    {
+        return arena != other.arena;
+    }
+};
+
+#endif // ARENA_H
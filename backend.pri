@@ -0,0 +1,49 @@
+######################################################################
+# The quiz backend, shared by the GUI and the command line tools.
+# None of these files depend on Qt.
+######################################################################
+
+HEADERS += answerjournal.hpp \
+           arena.hpp \
+           binaryreader.hpp \
+           bufferedwriter.hpp \
+           casefold.hpp \
+           compactdictionary.hpp \
+           connection.hpp \
+           connectiontable.hpp \
+           editdistance.hpp \
+           exceptions.hpp \
+           fieldscanner.hpp \
+           languagepair.hpp \
+           languageregistry.hpp \
+           profilecache.hpp \
+           profilemanager.hpp \
+           profilesnapshot.hpp \
+           quizlist.hpp \
+           quizscheduler.hpp \
+           userprofile.hpp \
+           util_global.hpp \
+           vocabquiz.hpp \
+           wordcompleter.hpp \
+           wordpool.hpp
+SOURCES += answerjournal.cpp \
+           arena.cpp \
+           bufferedwriter.cpp \
+           casefold.cpp \
+           compactdictionary.cpp \
+           connection.cpp \
+           connectiontable.cpp \
+           editdistance.cpp \
+           fieldscanner.cpp \
+           languagepair.cpp \
+           languageregistry.cpp \
+           profilecache.cpp \
+           profilemanager.cpp \
+           profilesnapshot.cpp \
+           quizlist.cpp \
+           quizscheduler.cpp \
+           userprofile.cpp \
+           vocabquiz.cpp \
+           wordcompleter.cpp \
+           wordpool.cpp
+LIBS += -lboost_thread -lboost_system
@@ -0,0 +1,211 @@
+/**
+ * @file batchgrader.cpp
+ * @brief Grades answer sheets against a dictionary without the GUI.
+ * @author Alex Zirbel
+ *
+ * A command line front end to the quiz engine, for grading whole answer
+ * sheets at once. The dictionary is loaded into a MasterList just as the GUI
+ * loads it, and every answer goes through FillInVocabQuiz::isCorrectAnswer,
+ * so the grader accepts exactly what an interactive quiz would accept.
+ *
+ * Answers are read from a file, or from standard input, one per line:
+ *
+ *   <prompt>\t<answer>
+ *
+ * and each is printed back with its grade:
+ *
+ *   <prompt>\t<answer>\t<correct|wrong>
+ *
+ * A summary with the grading throughput is printed to standard error.
+ *
+ * Usage: batchgrader [-r] [-i] [-t typos] [-j threads] <dictionary> [answers]
+ *   -r          Prompts are in the second language (REVERSE direction)
+ *   -i          Ignore capitalization when grading
+ *   -t typos    Accept answers with up to this many typos (default: 0)
+ *   -j threads  Grade on this many threads (default: one per core)
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <clocale>
+#include <cstdlib>
+#include <cstring>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "quizlist.hpp"
+#include "vocabquiz.hpp"
+
+using namespace std;
+using boost::posix_time::ptime;
+using boost::posix_time::microsec_clock;
+
+/**
+ * One line of an answer sheet.
+ */
+struct AnswerRecord
+{
+    string prompt;
+    string answer;
+    bool correct;
+};
+
+/**
+ * Grades a range of records on a worker thread.
+ */
+struct GradingTask
+{
+    FillInVocabQuiz *quiz;
+    vector<AnswerRecord> *records;
+    size_t begin;
+    size_t end;
+
+    void operator()()
+    {
+        for(size_t i = begin; i < end; i++)
+        {
+            AnswerRecord &record = (*records)[i];
+            record.correct = quiz->isCorrectAnswer(record.prompt, record.answer);
+        }
+    }
+};
+
+static void printUsage()
+{
+    cerr << "Usage: batchgrader [-r] [-i] [-t typos] [-j threads] "
+         << "<dictionary> [answers]" << endl;
+}
+
+/**
+ * Reads every record from an answer sheet. Lines without a tab are graded
+ * as an empty answer to the whole line.
+ */
+static void readRecords(istream &in, vector<AnswerRecord> &records)
+{
+    string line;
+
+    while(getline(in, line))
+    {
+        AnswerRecord record;
+        size_t tab = line.find('\t');
+
+        record.prompt = line.substr(0, tab);
+        if(tab != string::npos)
+            record.answer = line.substr(tab + 1);
+        record.correct = false;
+
+        records.push_back(record);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int direction = STANDARD;
+    bool caseSensitive = true;
+    int maxTypos = 0;
+    unsigned int numThreads = boost::thread::hardware_concurrency();
+    vector<string> files;
+
+    // Case insensitive grading folds non-ASCII letters in the user's locale
+    setlocale(LC_CTYPE, "");
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-r") == 0)
+            direction = REVERSE;
+        else if(strcmp(argv[i], "-i") == 0)
+            caseSensitive = false;
+        else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            maxTypos = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            numThreads = atoi(argv[++i]);
+        else if(argv[i][0] == '-')
+        {
+            printUsage();
+            return 1;
+        }
+        else
+            files.push_back(argv[i]);
+    }
+
+    if(files.empty() || files.size() > 2)
+    {
+        printUsage();
+        return 1;
+    }
+    if(numThreads == 0)
+        numThreads = 1;
+
+    MasterList dictionary;
+    if(!dictionary.loadFromMappedFile(files[0]))
+    {
+        cerr << "Unable to load dictionary " << files[0] << "." << endl;
+        return 1;
+    }
+
+    vector<AnswerRecord> records;
+    if(files.size() == 2)
+    {
+        ifstream answerFile(files[1].c_str());
+        if(!answerFile.is_open())
+        {
+            cerr << "Unable to open answers " << files[1] << "." << endl;
+            return 1;
+        }
+        readRecords(answerFile, records);
+    }
+    else
+    {
+        readRecords(cin, records);
+    }
+
+    FillInVocabQuiz quiz(&dictionary);
+    quiz.setDirection(direction);
+    quiz.setCaseSensitive(caseSensitive);
+    quiz.setMaxTypos(maxTypos);
+
+    ptime start = microsec_clock::universal_time();
+
+    // Split the records evenly; the main thread grades the first share
+    vector<GradingTask> tasks(numThreads);
+    size_t share = (records.size() + numThreads - 1) / numThreads;
+    for(unsigned int i = 0; i < numThreads; i++)
+    {
+        tasks[i].quiz = &quiz;
+        tasks[i].records = &records;
+        tasks[i].begin = min(records.size(), i * share);
+        tasks[i].end = min(records.size(), (i + 1) * share);
+    }
+
+    boost::thread_group workers;
+    for(unsigned int i = 1; i < numThreads; i++)
+        workers.create_thread(tasks[i]);
+    tasks[0]();
+    workers.join_all();
+
+    double seconds = (microsec_clock::universal_time() - start)
+                     .total_microseconds() / 1000000.0;
+
+    size_t numRight = 0;
+    vector<AnswerRecord>::iterator itr;
+    for(itr = records.begin(); itr != records.end(); itr++)
+    {
+        cout << itr->prompt << "\t" << itr->answer << "\t"
+             << (itr->correct ? "correct" : "wrong") << "\n";
+        if(itr->correct)
+            numRight++;
+    }
+    cout.flush();
+
+    cerr << "Graded " << records.size() << " answers (" << numRight
+         << " correct) on " << numThreads << " threads in " << seconds
+         << " s";
+    if(seconds > 0)
+        cerr << ": " << (records.size() / seconds) << " answers/s";
+    cerr << endl;
+
+    return 0;
+}
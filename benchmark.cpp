@@ -0,0 +1,654 @@
+/**
+ * @file benchmark.cpp
+ * @brief Microbenchmarks for the parsing, lookup and profile I/O hot paths.
+ * @author Alex Zirbel
+ *
+ * Times the functions which dominate loading and quizzing large dictionaries,
+ * at several synthetic dictionary sizes, so that performance changes can be
+ * measured rather than guessed. Each benchmark is run BENCHMARK_REPETITIONS
+ * times and the fastest run is reported.
+ *
+ * Results are printed to standard output as CSV, one line per benchmark and
+ * size:
+ *
+ *   benchmark,size,operations,seconds,ns_per_op,ops_per_s
+ *
+ * Usage: benchmark [-d directory] [size ...]
+ *   -d directory  Where to write the synthetic files (default: /tmp)
+ *   size          Dictionary sizes to run at (default: 1000 10000 100000)
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "casefold.hpp"
+#include "compactdictionary.hpp"
+#include "connection.hpp"
+#include "languagepair.hpp"
+#include "quizlist.hpp"
+#include "userprofile.hpp"
+#include "wordcompleter.hpp"
+#include "wordpool.hpp"
+
+using namespace std;
+using boost::posix_time::ptime;
+using boost::posix_time::microsec_clock;
+
+//! How many times each benchmark is run; the fastest run is reported.
+#define BENCHMARK_REPETITIONS 3
+
+/**
+ * Measures wall clock time from its construction.
+ */
+class Stopwatch
+{
+ptime start;
+
+public:
+    Stopwatch()
+    {
+        start = microsec_clock::universal_time();
+    }
+
+    double seconds()
+    {
+        return (microsec_clock::universal_time() - start).total_microseconds()
+               / 1000000.0;
+    }
+};
+
+/**
+ * Builds deterministic pseudo-random words, so that every run benchmarks the
+ * same data without the words sharing long prefixes.
+ */
+class WordGenerator
+{
+unsigned int state;
+
+public:
+    WordGenerator(unsigned int seed)
+    {
+        state = seed;
+    }
+
+    string next()
+    {
+        string word;
+        state = state * 1103515245 + 12345;
+        size_t length = 3 + (state >> 16) % 10;
+
+        for(size_t i = 0; i < length; i++)
+        {
+            state = state * 1103515245 + 12345;
+            word += (char)('a' + (state >> 16) % 26);
+        }
+
+        // A capital letter now and then exercises case folding
+        if((state >> 20) % 4 == 0)
+            word[0] = toupper(word[0]);
+
+        return word;
+    }
+};
+
+/**
+ * One benchmark's timings for one dictionary size.
+ */
+struct BenchmarkResult
+{
+    size_t operations;
+    double seconds;
+};
+
+//! A benchmark runs once over a dictionary of the given size.
+typedef BenchmarkResult (*Benchmark)(size_t size);
+
+//! Where the synthetic files for the current size are written.
+static string dataDir = "/tmp";
+
+static string dictionaryFilename(size_t size)
+{
+    stringstream name;
+    name << dataDir << "/wordquiz-bench-dict-" << size << ".txt";
+    return name.str();
+}
+
+static string compactDictionaryFilename(size_t size)
+{
+    stringstream name;
+    name << dataDir << "/wordquiz-bench-dict-" << size << ".wqd";
+    return name.str();
+}
+
+static string profileFilename(size_t size, const char *extension)
+{
+    stringstream name;
+    name << dataDir << "/wordquiz-bench-profile-" << size << extension;
+    return name.str();
+}
+
+/**
+ * The i-th connection line of the synthetic dictionary of a given size, with
+ * statistics as they appear in a profile.
+ */
+static vector<string> connectionLines(size_t size)
+{
+    vector<string> lines;
+    WordGenerator english(1), german(2);
+
+    for(size_t i = 0; i < size; i++)
+    {
+        stringstream line;
+        line << english.next() << "\t" << german.next() << "\t"
+             << (i % 101) << "\t" << (1300000000 + i);
+        lines.push_back(line.str());
+    }
+
+    return lines;
+}
+
+/**
+ * Writes the synthetic dictionary and profiles for a given size.
+ */
+static void writeSyntheticFiles(size_t size)
+{
+    vector<string> lines = connectionLines(size);
+
+    ofstream dictFile(dictionaryFilename(size).c_str());
+    dictFile << "Benchmark\nEnglish\tGerman\n";
+    for(size_t i = 0; i < lines.size(); i++)
+        dictFile << lines[i] << "\n";
+    dictFile.close();
+
+    // The profile has the same words under two language pairs
+    ofstream userFile(profileFilename(size, ".txt").c_str());
+    userFile << "bench\nBenchmark User\n";
+    userFile << "---\nEnglish\tGerman\t1\n";
+    for(size_t i = 0; i < lines.size(); i++)
+        userFile << lines[i] << "\n";
+    userFile << "---\nEnglish\tFrench\t1\n";
+    for(size_t i = 0; i < lines.size(); i++)
+        userFile << lines[i] << "\n";
+    userFile.close();
+
+    UserProfile profile;
+    profile.loadProfile(profileFilename(size, ".txt"));
+    profile.saveBinaryProfile(profileFilename(size, ".wqp"));
+
+    MasterList dictionary;
+    dictionary.loadFromFile(dictionaryFilename(size));
+    dictionary.saveToCompactFile(compactDictionaryFilename(size));
+}
+
+static BenchmarkResult connectionLoadFromLine(size_t size)
+{
+    vector<string> lines = connectionLines(size);
+    WordPool pool;
+    BenchmarkResult result;
+
+    Stopwatch timer;
+    for(size_t i = 0; i < lines.size(); i++)
+    {
+        Connection conn;
+        conn.loadFromLine(lines[i], "English", "German", pool);
+    }
+    result.seconds = timer.seconds();
+    result.operations = lines.size();
+
+    return result;
+}
+
+static BenchmarkResult languagePairLoadFromLine(size_t size)
+{
+    const char *languages[] = { "English", "German", "French", "Spanish",
+                                "Italian", "Dutch", "Swedish", "Polish" };
+    vector<string> lines;
+    for(size_t i = 0; i < size; i++)
+    {
+        string line = languages[i % 8];
+        line += "\t";
+        line += languages[(i / 8 + i + 1) % 8];
+        line += (i % 2) ? "\t1" : "\t2";
+        lines.push_back(line);
+    }
+
+    BenchmarkResult result;
+    int status;
+
+    Stopwatch timer;
+    for(size_t i = 0; i < lines.size(); i++)
+    {
+        LanguagePair pair;
+        pair.loadFromLine(lines[i], &status);
+    }
+    result.seconds = timer.seconds();
+    result.operations = lines.size();
+
+    return result;
+}
+
+/**
+ * Looks up every word pair in the list, half of them with the translation
+ * replaced so that the lookup misses, alternating case sensitivity.
+ */
+static BenchmarkResult quizListContains(size_t size)
+{
+    MasterList list;
+    list.loadFromFile(dictionaryFilename(size));
+
+    vector<Connection> queries;
+    WordGenerator other(3);
+    size_t i;
+    for(i = 0; i < list.connections.size(); i++)
+    {
+        Connection conn = list.getConnection(i);
+
+        if(i % 2 == 0)
+            queries.push_back(conn);
+        else
+            queries.push_back(Connection(conn.getLang1(), conn.getLang2(),
+                                         conn.getWord1(), other.next()));
+    }
+
+    BenchmarkResult result;
+    size_t found = 0;
+
+    Stopwatch timer;
+    for(i = 0; i < queries.size(); i++)
+    {
+        if(list.contains(queries[i], i % 4 < 2))
+            found++;
+    }
+    result.seconds = timer.seconds();
+    result.operations = queries.size();
+
+    return result;
+}
+
+/**
+ * Compares every word with an upper cased copy of itself and with the next
+ * word, ignoring case.
+ */
+static BenchmarkResult caseInsensitiveEqualsWords(size_t size)
+{
+    vector<string> words, upper;
+    WordGenerator generator(4);
+    for(size_t i = 0; i < size; i++)
+    {
+        words.push_back(generator.next());
+        upper.push_back(words.back());
+        for(size_t j = 0; j < upper.back().size(); j++)
+            upper.back()[j] = toupper(upper.back()[j]);
+    }
+
+    BenchmarkResult result;
+    size_t equal = 0;
+
+    Stopwatch timer;
+    for(size_t i = 0; i < size; i++)
+    {
+        if(caseInsensitiveEquals(words[i], upper[i]))
+            equal++;
+        if(caseInsensitiveEquals(words[i], upper[(i + 1) % size]))
+            equal++;
+    }
+    result.seconds = timer.seconds();
+    result.operations = 2 * size;
+
+    return result;
+}
+
+static BenchmarkResult quizListSortByLang1(size_t size)
+{
+    MasterList list;
+    list.loadFromFile(dictionaryFilename(size));
+    BenchmarkResult result;
+
+    Stopwatch timer;
+    list.sortByLang1();
+    result.seconds = timer.seconds();
+    result.operations = list.connections.size();
+
+    return result;
+}
+
+/**
+ * Sorts a list from the profile, where the words have statistics.
+ */
+static BenchmarkResult quizListSortByLeastKnown(size_t size)
+{
+    UserProfile profile;
+    profile.loadProfile(profileFilename(size, ".txt"));
+    MasterList *list = profile.getMasterListForLanguages(
+            LanguagePair("English", "German", 1));
+    BenchmarkResult result;
+
+    Stopwatch timer;
+    list->sortByLeastKnown();
+    result.seconds = timer.seconds();
+    result.operations = list->connections.size();
+
+    return result;
+}
+
+/**
+ * Completes the first three letters of every second-language word.
+ */
+static BenchmarkResult wordCompleterComplete(size_t size)
+{
+    MasterList list;
+    list.loadFromFile(dictionaryFilename(size));
+    WordCompleter completer(&list, false);
+
+    vector<string> prefixes;
+    for(size_t i = 0; i < list.connections.size(); i++)
+        prefixes.push_back(list.connections.getWord2(i).substr(0, 3));
+
+    BenchmarkResult result;
+    vector<string> completions;
+
+    Stopwatch timer;
+    for(size_t i = 0; i < prefixes.size(); i++)
+    {
+        completions.clear();
+        completer.complete(prefixes[i], DEFAULT_MAX_COMPLETIONS, completions);
+    }
+    result.seconds = timer.seconds();
+    result.operations = prefixes.size();
+
+    return result;
+}
+
+static BenchmarkResult masterListLoadFromFile(size_t size)
+{
+    MasterList list;
+    BenchmarkResult result;
+
+    Stopwatch timer;
+    list.loadFromFile(dictionaryFilename(size));
+    result.seconds = timer.seconds();
+    result.operations = list.connections.size();
+
+    return result;
+}
+
+static BenchmarkResult masterListLoadFromMappedFile(size_t size)
+{
+    MasterList list;
+    BenchmarkResult result;
+
+    Stopwatch timer;
+    list.loadFromMappedFile(dictionaryFilename(size));
+    result.seconds = timer.seconds();
+    result.operations = list.connections.size();
+
+    return result;
+}
+
+static BenchmarkResult compactDictionaryBuild(size_t size)
+{
+    MasterList list;
+    list.loadFromFile(dictionaryFilename(size));
+
+    CompactDictionary dictionary;
+    BenchmarkResult result;
+
+    Stopwatch timer;
+    dictionary.build(list);
+    result.seconds = timer.seconds();
+    result.operations = dictionary.size();
+
+    return result;
+}
+
+static BenchmarkResult compactDictionaryLoadFromFile(size_t size)
+{
+    CompactDictionary dictionary;
+    BenchmarkResult result;
+
+    Stopwatch timer;
+    dictionary.loadFromFile(compactDictionaryFilename(size));
+    result.seconds = timer.seconds();
+    result.operations = dictionary.size();
+
+    return result;
+}
+
+/**
+ * Looks up the translations of every word in a mapped compact dictionary.
+ */
+static BenchmarkResult compactDictionaryFindTranslations(size_t size)
+{
+    MasterList list;
+    list.loadFromFile(dictionaryFilename(size));
+
+    CompactDictionary dictionary;
+    dictionary.loadFromFile(compactDictionaryFilename(size));
+
+    BenchmarkResult result;
+    vector<string> translations;
+
+    Stopwatch timer;
+    for(size_t i = 0; i < list.connections.size(); i++)
+    {
+        translations.clear();
+        dictionary.findTranslations(list.connections.getWord1(i),
+                                    translations);
+    }
+    result.seconds = timer.seconds();
+    result.operations = list.connections.size();
+
+    return result;
+}
+
+static BenchmarkResult userProfileLoadProfile(size_t size)
+{
+    UserProfile profile;
+    BenchmarkResult result;
+
+    Stopwatch timer;
+    profile.loadProfile(profileFilename(size, ".txt"));
+    result.seconds = timer.seconds();
+    result.operations = 2 * size;
+
+    return result;
+}
+
+static BenchmarkResult userProfileSaveProfile(size_t size)
+{
+    UserProfile profile;
+    profile.loadProfile(profileFilename(size, ".txt"));
+    BenchmarkResult result;
+
+    Stopwatch timer;
+    profile.saveProfile(profileFilename(size, ".out.txt"));
+    result.seconds = timer.seconds();
+    result.operations = 2 * size;
+
+    return result;
+}
+
+static BenchmarkResult userProfileLoadBinaryProfile(size_t size)
+{
+    UserProfile profile;
+    BenchmarkResult result;
+
+    Stopwatch timer;
+    profile.loadBinaryProfile(profileFilename(size, ".wqp"));
+    result.seconds = timer.seconds();
+    result.operations = 2 * size;
+
+    return result;
+}
+
+/**
+ * Loads a binary profile and one of its two master lists, which is what
+ * logging in and starting a quiz costs.
+ */
+static BenchmarkResult userProfileLoadBinarySection(size_t size)
+{
+    UserProfile profile;
+    BenchmarkResult result;
+
+    Stopwatch timer;
+    profile.loadBinaryProfile(profileFilename(size, ".wqp"));
+    profile.getMasterListForLanguages(LanguagePair("English", "German", 1));
+    result.seconds = timer.seconds();
+    result.operations = size;
+
+    return result;
+}
+
+/**
+ * Finds the profile's master lists by their languages, as a quiz does for
+ * every answer it records.
+ */
+static BenchmarkResult userProfileGetMasterList(size_t size)
+{
+    UserProfile profile;
+    profile.loadProfile(profileFilename(size, ".txt"));
+
+    LanguagePair languages[2] = { LanguagePair("English", "German", 1),
+                                  LanguagePair("german", "ENGLISH", 2) };
+    BenchmarkResult result;
+    size_t found = 0;
+
+    Stopwatch timer;
+    for(size_t i = 0; i < size; i++)
+    {
+        if(profile.getMasterListForLanguages(languages[i % 2]) != NULL)
+            found++;
+    }
+    result.seconds = timer.seconds();
+    result.operations = size;
+
+    return result;
+}
+
+static BenchmarkResult userProfileSaveBinaryProfile(size_t size)
+{
+    UserProfile profile;
+    profile.loadBinaryProfile(profileFilename(size, ".wqp"));
+    BenchmarkResult result;
+
+    Stopwatch timer;
+    profile.saveBinaryProfile(profileFilename(size, ".out.wqp"));
+    result.seconds = timer.seconds();
+    result.operations = 2 * size;
+
+    return result;
+}
+
+/**
+ * Runs a benchmark BENCHMARK_REPETITIONS times and prints the fastest run.
+ * Anything the benchmarked code prints itself is discarded, to keep the
+ * results machine readable.
+ */
+static void run(const char *name, Benchmark benchmark, size_t size)
+{
+    streambuf *results = cout.rdbuf();
+    stringstream discard;
+    cout.rdbuf(discard.rdbuf());
+
+    BenchmarkResult best = benchmark(size);
+
+    for(int i = 1; i < BENCHMARK_REPETITIONS; i++)
+    {
+        BenchmarkResult result = benchmark(size);
+        if(result.seconds < best.seconds)
+            best = result;
+    }
+
+    cout.rdbuf(results);
+
+    double perOp = (best.operations > 0) ?
+                   best.seconds * 1e9 / best.operations : 0;
+    double perSecond = (best.seconds > 0) ?
+                       best.operations / best.seconds : 0;
+
+    cout << name << "," << size << "," << best.operations << ","
+         << best.seconds << "," << perOp << "," << perSecond << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    vector<size_t> sizes;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+            dataDir = argv[++i];
+        else if(atol(argv[i]) > 0)
+            sizes.push_back(atol(argv[i]));
+        else
+        {
+            cerr << "Usage: benchmark [-d directory] [size ...]" << endl;
+            return 1;
+        }
+    }
+
+    if(sizes.empty())
+    {
+        sizes.push_back(1000);
+        sizes.push_back(10000);
+        sizes.push_back(100000);
+    }
+
+    // The profile loaders report on cout; keep the CSV clean
+    streambuf *results = cout.rdbuf();
+    stringstream discard;
+
+    cout << "benchmark,size,operations,seconds,ns_per_op,ops_per_s" << endl;
+
+    for(size_t i = 0; i < sizes.size(); i++)
+    {
+        size_t size = sizes[i];
+
+        cout.rdbuf(discard.rdbuf());
+        writeSyntheticFiles(size);
+        cout.rdbuf(results);
+
+        run("Connection::loadFromLine", connectionLoadFromLine, size);
+        run("LanguagePair::loadFromLine", languagePairLoadFromLine, size);
+        run("QuizList::contains", quizListContains, size);
+        run("caseInsensitiveEquals", caseInsensitiveEqualsWords, size);
+        run("QuizList::sortByLang1", quizListSortByLang1, size);
+        run("QuizList::sortByLeastKnown", quizListSortByLeastKnown, size);
+        run("WordCompleter::complete", wordCompleterComplete, size);
+        run("MasterList::loadFromFile", masterListLoadFromFile, size);
+        run("MasterList::loadFromMappedFile",
+            masterListLoadFromMappedFile, size);
+        run("CompactDictionary::build", compactDictionaryBuild, size);
+        run("CompactDictionary::loadFromFile",
+            compactDictionaryLoadFromFile, size);
+        run("CompactDictionary::findTranslations",
+            compactDictionaryFindTranslations, size);
+        run("UserProfile::loadProfile", userProfileLoadProfile, size);
+        run("UserProfile::saveProfile", userProfileSaveProfile, size);
+        run("UserProfile::loadBinaryProfile",
+            userProfileLoadBinaryProfile, size);
+        run("UserProfile::loadBinarySection",
+            userProfileLoadBinarySection, size);
+        run("UserProfile::getMasterListForLanguages",
+            userProfileGetMasterList, size);
+        run("UserProfile::saveBinaryProfile",
+            userProfileSaveBinaryProfile, size);
+
+        remove(dictionaryFilename(size).c_str());
+        remove(compactDictionaryFilename(size).c_str());
+        remove(profileFilename(size, ".txt").c_str());
+        remove(profileFilename(size, ".out.txt").c_str());
+        remove(profileFilename(size, ".wqp").c_str());
+        remove(profileFilename(size, ".out.wqp").c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file binaryreader.hpp
+ * @brief Reads the binary profile and dictionary formats.
+ * @author Alex Zirbel
+ */
+
+#ifndef BINARYREADER_H
+#define BINARYREADER_H
+
+#include <cstring>
+#include <string>
+#include <boost/cstdint.hpp>
+
+/**
+ * Reads values out of a buffer holding a binary file, failing cleanly
+ * rather than reading past the end of a truncated file.
+ */
+class BinaryReader
+{
+const char *pos;
+const char *end;
+
+public:
+    BinaryReader(const char *begin, const char *myEnd)
+    {
+        pos = begin;
+        end = myEnd;
+    }
+
+    //! Reads a fixed-size value.
+    template <typename T> bool read(T &value)
+    {
+        if((size_t)(end - pos) < sizeof(T))
+            return false;
+
+        memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    //! Returns a pointer to the next count bytes and skips over them.
+    bool readBlock(size_t count, const char *&block)
+    {
+        if((size_t)(end - pos) < count)
+            return false;
+
+        block = pos;
+        pos += count;
+        return true;
+    }
+
+    //! Reads a string stored as a uint32 length followed by its bytes.
+    bool readString(std::string &value)
+    {
+        boost::uint32_t length;
+        const char *bytes;
+
+        if(!read(length) || !readBlock(length, bytes))
+            return false;
+
+        value.assign(bytes, length);
+        return true;
+    }
+};
+
+#endif // BINARYREADER_H
@@ -0,0 +1,265 @@
+/**
+ * @file bufferedwriter.cpp
+ * @brief Writes files through one large buffer.
+ * @author Alex Zirbel
+ *
+ * Saving a profile or dictionary writes millions of short fields. Through
+ * iostreams each one goes through formatting state, locales and often a
+ * flush; here they are copied into a large buffer, with integers formatted
+ * by hand, and the buffer is handed to the operating system when it fills,
+ * so a save costs little more than the writes themselves.
+ *
+ * Errors are remembered rather than reported on every call: once a write
+ * fails, the rest are dropped, and close returns false.
+ *
+ * The file is never written in place. Everything goes to a temporary file
+ * in the same directory, which close syncs to disk and renames over the
+ * real file only once it is complete, so a crash or a failed write in the
+ * middle of a save leaves the previous file untouched.
+ */
+
+#include "bufferedwriter.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using boost::int64_t;
+using boost::uint64_t;
+
+/**
+ * Formats an unsigned integer in decimal.
+ * @param out Where the digits are written, at least MAX_INTEGER_DIGITS long
+ * @return The number of characters written
+ */
+size_t formatUnsigned(char *out, uint64_t value)
+{
+    // Digits come out backwards; build them at the end of a scratch buffer
+    char digits[MAX_INTEGER_DIGITS];
+    char *pos = digits + MAX_INTEGER_DIGITS;
+
+    do
+    {
+        *--pos = '0' + (char) (value % 10);
+        value /= 10;
+    }
+    while(value != 0);
+
+    size_t length = digits + MAX_INTEGER_DIGITS - pos;
+    memcpy(out, pos, length);
+    return length;
+}
+
+
+/**
+ * Formats a signed integer in decimal.
+ * @param out Where the digits are written, at least MAX_INTEGER_DIGITS long
+ * @return The number of characters written
+ */
+size_t formatInt(char *out, int64_t value)
+{
+    if(value >= 0)
+        return formatUnsigned(out, (uint64_t) value);
+
+    // Negating in unsigned arithmetic also works for the most negative value
+    out[0] = '-';
+    return 1 + formatUnsigned(out + 1, 0 - (uint64_t) value);
+}
+
+
+BufferedWriter::BufferedWriter() : buffer(WRITE_BUFFER_SIZE)
+{
+    fd = -1;
+    used = 0;
+    written = 0;
+    failed = false;
+}
+
+
+/**
+ * Throws away a file which was never closed, leaving the real file as it
+ * was; a save abandoned part way through must not replace it.
+ */
+BufferedWriter::~BufferedWriter()
+{
+    discard();
+}
+
+
+/**
+ * Starts writing a file. Nothing replaces the file until close is called.
+ * @return False if the temporary file could not be created.
+ */
+bool BufferedWriter::open(const string &filename)
+{
+    discard();
+
+    targetFilename = filename;
+    tempFilename = filename + TEMP_FILE_SUFFIX;
+
+    // mkstemp picks a name nobody else is using and fills in the X's
+    vector<char> name(tempFilename.begin(), tempFilename.end());
+    name.push_back('\0');
+    fd = mkstemp(&name[0]);
+    tempFilename = &name[0];
+
+    used = 0;
+    written = 0;
+    failed = (fd == -1);
+
+    if(failed)
+        return false;
+
+    // mkstemp only lets the owner read the file; keep the permissions of the
+    // file being replaced, or those a new file would have been given
+    struct stat existing;
+    mode_t mode = NEW_FILE_MODE;
+    if(stat(filename.c_str(), &existing) == 0)
+        mode = existing.st_mode & 07777;
+    fchmod(fd, mode);
+
+    return true;
+}
+
+
+/**
+ * Writes out whatever is still buffered, makes sure it is on disk, and
+ * moves the new file over the old one in a single step.
+ * @return True if everything written since open reached the file. If not,
+ *  the old file is left as it was.
+ */
+bool BufferedWriter::close()
+{
+    if(fd == -1)
+        return false;
+
+    flush();
+
+    if(!failed && fsync(fd) != 0)
+        failed = true;
+    if(::close(fd) != 0)
+        failed = true;
+    fd = -1;
+
+    if(!failed && rename(tempFilename.c_str(), targetFilename.c_str()) != 0)
+        failed = true;
+
+    if(failed)
+    {
+        remove(tempFilename.c_str());
+        return false;
+    }
+
+    syncDirectory();
+    return true;
+}
+
+
+/**
+ * Stops writing and deletes the temporary file, without touching the file
+ * it would have replaced.
+ */
+void BufferedWriter::discard()
+{
+    if(fd == -1)
+        return;
+
+    ::close(fd);
+    fd = -1;
+    used = 0;
+    failed = true;
+
+    remove(tempFilename.c_str());
+}
+
+
+/**
+ * Whether every write so far has succeeded.
+ */
+bool BufferedWriter::good() const
+{
+    return fd != -1 && !failed;
+}
+
+
+/**
+ * Syncs the directory holding the file, so that the rename which put the
+ * new file in place survives a crash as well as the data does.
+ */
+void BufferedWriter::syncDirectory()
+{
+    string directory = ".";
+    size_t slash = targetFilename.rfind('/');
+    if(slash == 0)
+        directory = "/";
+    else if(slash != string::npos)
+        directory = targetFilename.substr(0, slash);
+
+    int dirFd = ::open(directory.c_str(), O_RDONLY);
+    if(dirFd == -1)
+        return;
+
+    fsync(dirFd);
+    ::close(dirFd);
+}
+
+
+/**
+ * Hands the buffered data to the operating system.
+ */
+void BufferedWriter::flush()
+{
+    const char *pos = &buffer[0];
+    size_t remaining = used;
+    used = 0;
+
+    while(remaining != 0 && !failed)
+    {
+        ssize_t count = ::write(fd, pos, remaining);
+        if(count < 0)
+        {
+            if(errno != EINTR)
+                failed = true;
+            continue;
+        }
+
+        pos += count;
+        remaining -= count;
+    }
+}
+
+
+/**
+ * Writes data too large for what is left of the buffer: the buffer is
+ * flushed, and data larger than the whole buffer skips it.
+ */
+void BufferedWriter::writeThrough(const char *data, size_t size)
+{
+    flush();
+    written += size;
+
+    if(size < buffer.size())
+    {
+        memcpy(&buffer[0], data, size);
+        used = size;
+        return;
+    }
+
+    while(size != 0 && !failed)
+    {
+        ssize_t count = ::write(fd, data, size);
+        if(count < 0)
+        {
+            if(errno != EINTR)
+                failed = true;
+            continue;
+        }
+
+        data += count;
+        size -= count;
+    }
+}
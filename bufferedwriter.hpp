@@ -0,0 +1,116 @@
+/**
+ * @file bufferedwriter.hpp
+ * @brief Header definitions for the BufferedWriter class.
+ * @author Alex Zirbel
+ */
+
+#ifndef BUFFEREDWRITER_H
+#define BUFFEREDWRITER_H
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/utility/string_ref.hpp>
+
+//! How much is collected in memory before it is written to the file.
+#define WRITE_BUFFER_SIZE (1024 * 1024)
+
+//! Enough room to format any 64-bit integer, with its sign.
+#define MAX_INTEGER_DIGITS 21
+
+//! Appended to a file's name to make the name it is written under until it
+//! is complete. The X's are replaced by mkstemp.
+#define TEMP_FILE_SUFFIX ".tmp.XXXXXX"
+//! The permissions of a file which did not exist before it was written.
+#define NEW_FILE_MODE 0644
+
+size_t formatInt(char *out, boost::int64_t value);
+size_t formatUnsigned(char *out, boost::uint64_t value);
+
+class BufferedWriter : boost::noncopyable
+{
+//! The temporary file being written, or -1 if none is open.
+int fd;
+//! The file which is replaced when the temporary file is closed.
+std::string targetFilename;
+std::string tempFilename;
+std::vector<char> buffer;
+//! How much of buffer holds data not yet written.
+size_t used;
+//! Bytes handed to the writer since the file was opened.
+boost::uint64_t written;
+//! Set once any write has failed; everything after is dropped.
+bool failed;
+
+public:
+    BufferedWriter();
+    ~BufferedWriter();
+
+    bool open(const std::string &filename);
+    bool close();
+    void discard();
+    bool good() const;
+
+    //! Bytes written since the file was opened, buffered or not.
+    boost::uint64_t position() const { return written; }
+
+    void write(const char *data, size_t size)
+    {
+        if(size <= buffer.size() - used)
+        {
+            memcpy(&buffer[used], data, size);
+            used += size;
+            written += size;
+        }
+        else
+            writeThrough(data, size);
+    }
+
+    void write(boost::string_ref text)
+    {
+        write(text.data(), text.size());
+    }
+
+    void put(char c)
+    {
+        if(used == buffer.size())
+            flush();
+        buffer[used++] = c;
+        written++;
+    }
+
+    void writeInt(boost::int64_t value)
+    {
+        char digits[MAX_INTEGER_DIGITS];
+        write(digits, formatInt(digits, value));
+    }
+
+    void writeUnsigned(boost::uint64_t value)
+    {
+        char digits[MAX_INTEGER_DIGITS];
+        write(digits, formatUnsigned(digits, value));
+    }
+
+    //! Writes a fixed-size value in the host's byte order.
+    template <typename T> void writeValue(T value)
+    {
+        write((const char*) &value, sizeof(T));
+    }
+
+    //! Writes a string as a uint32 length followed by its bytes, as
+    //! BinaryReader::readString reads it.
+    void writeString(boost::string_ref text)
+    {
+        writeValue<boost::uint32_t>(text.size());
+        write(text);
+    }
+
+private:
+    void syncDirectory();
+    void flush();
+    void writeThrough(const char *data, size_t size);
+};
+
+#endif // BUFFEREDWRITER_H
@@ -0,0 +1,287 @@
+/**
+ * @file casefold.cpp
+ * @brief Compares words case insensitively, with a vectorised ASCII path.
+ * @author Alex Zirbel
+ *
+ * Two words are equal ignoring case when their case folded forms, as built
+ * by foldCase, are equal. Almost every word compared in a quiz is plain
+ * ASCII, so caseInsensitiveEquals compares 16 bytes at a time with SSE2 (32
+ * with AVX2, when the compiler is allowed to use it), folding A-Z as it
+ * goes. Only when a byte outside ASCII turns up does it fall back to folding
+ * the rest of both words in full.
+ *
+ * The full folding decodes UTF-8 and lower cases each character with
+ * towlower, so it follows the LC_CTYPE locale: the GUI sets it from the
+ * environment, and so do the command line tools. Bytes which are not valid
+ * UTF-8 are kept as they are.
+ */
+
+#include "casefold.hpp"
+
+#include <cwctype>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+using boost::string_ref;
+
+//! How far compareAscii got through two words.
+enum AsciiResult
+{
+    ASCII_MATCH,
+    ASCII_MISMATCH,
+    NOT_ASCII
+};
+
+/**
+ * Compares n bytes of two words, folding ASCII case, until they differ or a
+ * byte outside ASCII is found.
+ * @param offset Set to where the first block holding a non-ASCII byte
+ *  starts. Everything before it is ASCII and equal ignoring case.
+ */
+static AsciiResult compareAscii(const char *a, const char *b, size_t n,
+                                size_t *offset)
+{
+    size_t i = 0;
+
+#ifdef __AVX2__
+    const __m256i upperMin32 = _mm256_set1_epi8('A' - 1);
+    const __m256i upperMax32 = _mm256_set1_epi8('Z' + 1);
+    const __m256i caseBit32 = _mm256_set1_epi8(0x20);
+
+    for(; i + 32 <= n; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+
+        if(_mm256_movemask_epi8(_mm256_or_si256(x, y)) != 0)
+        {
+            *offset = i;
+            return NOT_ASCII;
+        }
+
+        // Signed comparisons are safe: every byte is below 0x80 here
+        __m256i upperX = _mm256_and_si256(_mm256_cmpgt_epi8(x, upperMin32),
+                                          _mm256_cmpgt_epi8(upperMax32, x));
+        __m256i upperY = _mm256_and_si256(_mm256_cmpgt_epi8(y, upperMin32),
+                                          _mm256_cmpgt_epi8(upperMax32, y));
+        x = _mm256_or_si256(x, _mm256_and_si256(upperX, caseBit32));
+        y = _mm256_or_si256(y, _mm256_and_si256(upperY, caseBit32));
+
+        if(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)) != -1)
+            return ASCII_MISMATCH;
+    }
+#endif
+
+#ifdef __SSE2__
+    const __m128i upperMin = _mm_set1_epi8('A' - 1);
+    const __m128i upperMax = _mm_set1_epi8('Z' + 1);
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+
+    for(; i + 16 <= n; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i*)(b + i));
+
+        if(_mm_movemask_epi8(_mm_or_si128(x, y)) != 0)
+        {
+            *offset = i;
+            return NOT_ASCII;
+        }
+
+        __m128i upperX = _mm_and_si128(_mm_cmpgt_epi8(x, upperMin),
+                                       _mm_cmpgt_epi8(upperMax, x));
+        __m128i upperY = _mm_and_si128(_mm_cmpgt_epi8(y, upperMin),
+                                       _mm_cmpgt_epi8(upperMax, y));
+        x = _mm_or_si128(x, _mm_and_si128(upperX, caseBit));
+        y = _mm_or_si128(y, _mm_and_si128(upperY, caseBit));
+
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xFFFF)
+            return ASCII_MISMATCH;
+    }
+#endif
+
+    // The tail, or everything without SSE2
+    for(; i < n; i++)
+    {
+        if((a[i] | b[i]) & 0x80)
+        {
+            *offset = i;
+            return NOT_ASCII;
+        }
+
+        if(foldAsciiCase(a[i]) != foldAsciiCase(b[i]))
+            return ASCII_MISMATCH;
+    }
+
+    return ASCII_MATCH;
+}
+
+/**
+ * Decodes one UTF-8 character.
+ * @param pos The start of the character; moved past it on return
+ * @return The character, or 0 with pos unmoved if the bytes are not a valid
+ *  UTF-8 sequence.
+ */
+static wint_t decodeUtf8(const char *&pos, const char *end)
+{
+    unsigned char lead = *pos;
+    size_t length;
+    wint_t character;
+
+    if(lead >= 0xC2 && lead <= 0xDF)
+    {
+        length = 2;
+        character = lead & 0x1F;
+    }
+    else if(lead >= 0xE0 && lead <= 0xEF)
+    {
+        length = 3;
+        character = lead & 0x0F;
+    }
+    else if(lead >= 0xF0 && lead <= 0xF4)
+    {
+        length = 4;
+        character = lead & 0x07;
+    }
+    else
+        return 0;
+
+    if((size_t)(end - pos) < length)
+        return 0;
+
+    for(size_t i = 1; i < length; i++)
+    {
+        unsigned char next = pos[i];
+        if((next & 0xC0) != 0x80)
+            return 0;
+        character = (character << 6) | (next & 0x3F);
+    }
+
+    // Reject overlong forms, surrogates and anything past U+10FFFF
+    if((length == 3 && character < 0x800) ||
+       (length == 4 && (character < 0x10000 || character > 0x10FFFF)) ||
+       (character >= 0xD800 && character <= 0xDFFF))
+        return 0;
+
+    pos += length;
+    return character;
+}
+
+static void appendUtf8(string &out, wint_t character)
+{
+    if(character < 0x80)
+        out += (char) character;
+    else if(character < 0x800)
+    {
+        out += (char)(0xC0 | (character >> 6));
+        out += (char)(0x80 | (character & 0x3F));
+    }
+    else if(character < 0x10000)
+    {
+        out += (char)(0xE0 | (character >> 12));
+        out += (char)(0x80 | ((character >> 6) & 0x3F));
+        out += (char)(0x80 | (character & 0x3F));
+    }
+    else
+    {
+        out += (char)(0xF0 | (character >> 18));
+        out += (char)(0x80 | ((character >> 12) & 0x3F));
+        out += (char)(0x80 | ((character >> 6) & 0x3F));
+        out += (char)(0x80 | (character & 0x3F));
+    }
+}
+
+
+/**
+ * Checks whether two words are equal ignoring case, that is, whether their
+ * case folded forms are equal. Allocates nothing unless a word holds
+ * characters outside ASCII.
+ */
+bool caseInsensitiveEquals(string_ref a, string_ref b)
+{
+    size_t common = (a.size() < b.size()) ? a.size() : b.size();
+    size_t offset = 0;
+
+    switch(compareAscii(a.data(), b.data(), common, &offset))
+    {
+    case ASCII_MISMATCH:
+        return false;
+
+    case ASCII_MATCH:
+        // Folding never empties a character, so the longer word is longer
+        // folded as well.
+        return a.size() == b.size();
+
+    default:
+        // The words agree up to offset, which is a character boundary in
+        // both; folding can change the length of what follows.
+        return foldCase(a.substr(offset)) == foldCase(b.substr(offset));
+    }
+}
+
+/**
+ * Orders two words by their case folded forms, byte by byte.
+ * @return Less than, equal to or greater than zero as a comes before, with
+ *  or after b.
+ */
+int caseInsensitiveCompare(string_ref a, string_ref b)
+{
+    size_t common = (a.size() < b.size()) ? a.size() : b.size();
+
+    for(size_t i = 0; i < common; i++)
+    {
+        if((a[i] | b[i]) & 0x80)
+            return foldCase(a.substr(i)).compare(foldCase(b.substr(i)));
+
+        unsigned char x = foldAsciiCase(a[i]);
+        unsigned char y = foldAsciiCase(b[i]);
+        if(x != y)
+            return (x < y) ? -1 : 1;
+    }
+
+    if(a.size() == b.size())
+        return 0;
+
+    return (a.size() < b.size()) ? -1 : 1;
+}
+
+/**
+ * Builds the case folded form of a word: ASCII letters in lower case, other
+ * UTF-8 characters lower cased by towlower, and anything else unchanged.
+ */
+string foldCase(string_ref text)
+{
+    string folded;
+    folded.reserve(text.size());
+
+    const char *pos = text.data();
+    const char *end = pos + text.size();
+
+    while(pos != end)
+    {
+        if((*pos & 0x80) == 0)
+        {
+            folded += foldAsciiCase(*pos);
+            pos++;
+            continue;
+        }
+
+        wint_t character = decodeUtf8(pos, end);
+        if(character == 0)
+        {
+            // Not UTF-8: keep the byte
+            folded += *pos;
+            pos++;
+        }
+        else
+            appendUtf8(folded, towlower(character));
+    }
+
+    return folded;
+}
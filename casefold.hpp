@@ -0,0 +1,37 @@
+/**
+ * @file casefold.hpp
+ * @brief Declarations for case insensitive comparison of words.
+ * @author Alex Zirbel
+ */
+
+#ifndef CASEFOLD_H
+#define CASEFOLD_H
+
+#include <string>
+#include <boost/utility/string_ref.hpp>
+
+bool caseInsensitiveEquals(boost::string_ref a, boost::string_ref b);
+int caseInsensitiveCompare(boost::string_ref a, boost::string_ref b);
+std::string foldCase(boost::string_ref text);
+
+/**
+ * Folds an ASCII character to lower case. Other bytes are returned as they
+ * are, whatever the locale.
+ */
+inline char foldAsciiCase(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+}
+
+/**
+ * A drop-in predicate for containers keyed case insensitively.
+ */
+struct CaseInsensitiveEqual
+{
+    bool operator()(boost::string_ref a, boost::string_ref b) const
+    {
+        return caseInsensitiveEquals(a, b);
+    }
+};
+
+#endif // CASEFOLD_H
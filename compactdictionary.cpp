@@ -0,0 +1,583 @@
+/**
+ * @file compactdictionary.cpp
+ * @brief A sorted, front-coded, read-only dictionary.
+ * @author Alex Zirbel
+ *
+ * Large dictionaries are full of words which start the same way: the
+ * inflections of one word, compounds, and phrases which begin with the same
+ * article. Sorted, neighbouring words share long prefixes, so each word is
+ * stored as the length of the prefix it shares with the word before it and
+ * the rest of its letters ("front coding"). The translations are coded the
+ * same way against the previous translation.
+ *
+ * The entries are split into blocks of FRONT_CODING_BLOCK_SIZE. The first
+ * entry of a block shares nothing with the one before it, so any block can
+ * be decoded on its own, and a small index holds where each block starts.
+ * Finding a word is a binary search over the first words of the blocks
+ * followed by a scan through at most two blocks.
+ *
+ * A dictionary can be built from a loaded list and saved, or loaded from a
+ * saved file, which is mapped rather than read: the entries are used where
+ * they lie in the file, so opening even a very large dictionary for
+ * browsing and lookups costs little more than reading its index. Lengths are
+ * written as variable length integers, seven bits to a byte, lowest first.
+ *
+ * The file holds, in the host's byte order:
+ *
+ *   - the four bytes of COMPACT_DICTIONARY_MAGIC, then uint32 version,
+ *     uint32 block size and uint64 entry count,
+ *   - the list name and the two languages, each a uint32 length followed by
+ *     its bytes,
+ *   - uint64 block count and uint64 size of the entries,
+ *   - uint64 offset of each block in the entries,
+ *   - the entries.
+ *
+ * Statistics are not stored: like the other dictionary formats, this one
+ * only holds words, and quiz statistics belong in the user's profile.
+ */
+
+#include "compactdictionary.hpp"
+#include "binaryreader.hpp"
+#include "bufferedwriter.hpp"
+#include "quizlist.hpp"
+
+#include <algorithm>
+#include <boost/interprocess/file_mapping.hpp>
+
+using namespace std;
+using namespace boost;
+using boost::interprocess::mapped_region;
+
+/**
+ * Where a scan through the entries has got to.
+ */
+struct CompactDictionary::Cursor
+{
+    //! The index of the entry which will be read next.
+    size_t index;
+    const char *pos;
+    const char *end;
+    //! The entry read last.
+    DictionaryEntry entry;
+};
+
+/**
+ * Orders the rows of a connection table by their words, so that they can be
+ * front coded.
+ */
+struct RowOrder
+{
+    const ConnectionTable *table;
+
+    bool operator()(size_t a, size_t b) const
+    {
+        int order = table->getWord1(a).compare(table->getWord1(b));
+        if(order != 0)
+            return order < 0;
+
+        return table->getWord2(a) < table->getWord2(b);
+    }
+};
+
+static void appendVarint(vector<char> &out, size_t value)
+{
+    while(value >= 0x80)
+    {
+        out.push_back((char) ((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back((char) value);
+}
+
+static bool readVarint(const char *&pos, const char *end, size_t &value)
+{
+    uint64_t result = 0;
+
+    for(unsigned int shift = 0; pos != end && shift < 64; shift += 7)
+    {
+        unsigned char byte = (unsigned char) *pos++;
+        result |= (uint64_t) (byte & 0x7f) << shift;
+
+        if((byte & 0x80) == 0)
+        {
+            value = (size_t) result;
+            return value == result;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Appends a word as the length of the prefix it shares with the previous
+ * word, the length of the rest, and the rest.
+ * @param previous The word before it in the block, or NULL for the first
+ */
+static void appendWord(vector<char> &out, const string *previous,
+                       const string &word)
+{
+    size_t shared = 0;
+    if(previous != NULL)
+    {
+        size_t limit = min(previous->size(), word.size());
+        while(shared < limit && (*previous)[shared] == word[shared])
+            shared++;
+    }
+
+    appendVarint(out, shared);
+    appendVarint(out, word.size() - shared);
+    out.insert(out.end(), word.begin() + shared, word.end());
+}
+
+/**
+ * Reads a word written by appendWord over the previous word, which is
+ * still in word.
+ */
+static bool readWord(const char *&pos, const char *end, string &word)
+{
+    size_t shared, rest;
+
+    if(!readVarint(pos, end, shared) || !readVarint(pos, end, rest))
+        return false;
+    if(shared > word.size() || (size_t)(end - pos) < rest)
+        return false;
+
+    word.resize(shared);
+    word.append(pos, rest);
+    pos += rest;
+    return true;
+}
+
+
+CompactDictionary::CompactDictionary()
+{
+    clear();
+}
+
+
+/**
+ * Replaces the contents of the dictionary with the words of a list. The
+ * list's statistics are not kept.
+ * @param list The list to copy; it is not changed
+ */
+void CompactDictionary::build(const QuizList &list)
+{
+    clear();
+
+    listName = list.listName;
+    list.getColumnLanguages(lang1, lang2);
+
+    const ConnectionTable &table = list.connections;
+
+    vector<size_t> order(table.size());
+    for(size_t row = 0; row < order.size(); row++)
+        order[row] = row;
+
+    RowOrder byWords;
+    byWords.table = &table;
+    sort(order.begin(), order.end(), byWords);
+
+    const string *previous1 = NULL;
+    const string *previous2 = NULL;
+
+    for(size_t i = 0; i < order.size(); i++)
+    {
+        // Every block starts afresh, so that it can be decoded on its own
+        if(i % blockSize == 0)
+        {
+            blockOffsets.push_back(ownedData.size());
+            previous1 = previous2 = NULL;
+        }
+
+        const string &word1 = table.getWord1(order[i]);
+        const string &word2 = table.getWord2(order[i]);
+
+        appendWord(ownedData, previous1, word1);
+        appendWord(ownedData, previous2, word2);
+
+        previous1 = &word1;
+        previous2 = &word2;
+    }
+
+    numEntries = order.size();
+    dataSize = ownedData.size();
+    data = ownedData.empty() ? NULL : &ownedData[0];
+}
+
+
+/**
+ * Opens a compact dictionary file. The file stays mapped for as long as the
+ * dictionary uses it.
+ * @param filename The location of the file
+ * @return True if the file was a complete compact dictionary. If not, the
+ *  dictionary is left empty.
+ */
+bool CompactDictionary::loadFromFile(string filename)
+{
+    using namespace boost::interprocess;
+
+    clear();
+
+    boost::shared_ptr<mapped_region> region(new mapped_region);
+    try
+    {
+        file_mapping file(filename.c_str(), read_only);
+        mapped_region mapped(file, read_only);
+        region->swap(mapped);
+    }
+    catch(interprocess_exception &)
+    {
+        return false;
+    }
+
+    const char *begin = (const char*) region->get_address();
+    BinaryReader reader(begin, begin + region->get_size());
+
+    const char *magic, *offsets, *entries;
+    uint32_t version, fileBlockSize;
+    uint64_t fileEntries, numBlocks, fileDataSize;
+
+    if(!reader.readBlock(4, magic) ||
+       memcmp(magic, COMPACT_DICTIONARY_MAGIC, 4) != 0)
+        return false;
+    if(!reader.read(version) || version != COMPACT_DICTIONARY_VERSION)
+        return false;
+    if(!reader.read(fileBlockSize) || fileBlockSize == 0 ||
+       !reader.read(fileEntries))
+        return false;
+    if(!reader.readString(listName) || !reader.readString(lang1) ||
+       !reader.readString(lang2) ||
+       !reader.read(numBlocks) || !reader.read(fileDataSize))
+    {
+        clear();
+        return false;
+    }
+
+    // Every block but the last is full
+    if(numBlocks != (fileEntries + fileBlockSize - 1) / fileBlockSize ||
+       numBlocks > region->get_size() / sizeof(uint64_t))
+    {
+        clear();
+        return false;
+    }
+
+    if(!reader.readBlock(numBlocks * sizeof(uint64_t), offsets) ||
+       !reader.readBlock(fileDataSize, entries))
+    {
+        clear();
+        return false;
+    }
+
+    blockOffsets.resize(numBlocks);
+    if(numBlocks != 0)
+        memcpy(&blockOffsets[0], offsets, numBlocks * sizeof(uint64_t));
+
+    // Blocks are decoded without further checks on where they start
+    for(size_t block = 0; block < blockOffsets.size(); block++)
+    {
+        if(blockOffsets[block] > fileDataSize ||
+           (block > 0 && blockOffsets[block] < blockOffsets[block - 1]))
+        {
+            clear();
+            return false;
+        }
+    }
+
+    blockSize = fileBlockSize;
+    numEntries = fileEntries;
+    data = entries;
+    dataSize = fileDataSize;
+    mapping = region;
+
+    return true;
+}
+
+
+/**
+ * Saves the dictionary in the format loadFromFile reads.
+ * @param filename The location of the file to write
+ * @return True if the whole dictionary was written, false otherwise
+ */
+bool CompactDictionary::saveToFile(string filename) const
+{
+    BufferedWriter dictFile;
+
+    // Check for failed file open
+    if(!dictFile.open(filename))
+        return false;
+
+    dictFile.write(COMPACT_DICTIONARY_MAGIC, 4);
+    dictFile.writeValue<uint32_t>(COMPACT_DICTIONARY_VERSION);
+    dictFile.writeValue<uint32_t>(blockSize);
+    dictFile.writeValue<uint64_t>(numEntries);
+    dictFile.writeString(listName);
+    dictFile.writeString(lang1);
+    dictFile.writeString(lang2);
+    dictFile.writeValue<uint64_t>(blockOffsets.size());
+    dictFile.writeValue<uint64_t>(dataSize);
+
+    for(size_t block = 0; block < blockOffsets.size(); block++)
+        dictFile.writeValue<uint64_t>(blockOffsets[block]);
+
+    dictFile.write(data, dataSize);
+
+    return dictFile.close();
+}
+
+
+/**
+ * Adds every entry of the dictionary to a master list, in sorted order, so
+ * that it can be quizzed like a list loaded from a text dictionary.
+ * @param list The list to fill; its name and languages are replaced
+ */
+void CompactDictionary::expand(MasterList &list) const
+{
+    list.listName = listName;
+    list.lang1 = lang1;
+    list.lang2 = lang2;
+    list.connections.reserve(list.connections.size() + numEntries);
+
+    Cursor cursor;
+    seek(cursor, 0);
+
+    while(next(cursor))
+    {
+        list.addPooledConnection(Connection(*list.wordPool, lang1, lang2,
+                                            cursor.entry.word1,
+                                            cursor.entry.word2));
+    }
+}
+
+
+/**
+ * The number of entries in the dictionary.
+ */
+size_t CompactDictionary::size() const
+{
+    return numEntries;
+}
+
+
+/**
+ * Roughly how much memory the dictionary's words and index take, whether
+ * they were built in memory or are mapped from a file.
+ */
+size_t CompactDictionary::bytesUsed() const
+{
+    return sizeof(*this) + listName.size() + lang1.size() + lang2.size() +
+           blockOffsets.size() * sizeof(uint64_t) + dataSize;
+}
+
+
+/**
+ * Reads a run of entries in sorted order, for browsing the dictionary a
+ * page at a time.
+ * @param first The index of the first entry to read
+ * @param count How many entries to read at most
+ * @param entries Where the entries are appended
+ * @return The number of entries appended
+ */
+size_t CompactDictionary::getEntries(size_t first, size_t count,
+                                     vector<DictionaryEntry> &entries) const
+{
+    Cursor cursor;
+    seek(cursor, first);
+
+    size_t numRead = 0;
+    while(numRead < count && next(cursor))
+    {
+        entries.push_back(cursor.entry);
+        numRead++;
+    }
+
+    return numRead;
+}
+
+
+/**
+ * Finds the first entry whose first word is not less than a word, in the
+ * byte order the entries are sorted in.
+ * @return The index of the entry, or size() if every word is less
+ */
+size_t CompactDictionary::lowerBound(string_ref word1) const
+{
+    Cursor cursor;
+
+    if(!seekWord(cursor, word1))
+        return numEntries;
+
+    return cursor.index - 1;
+}
+
+
+/**
+ * Finds every translation of a word in the first language.
+ * @param word1 The word to look up, exactly as it is spelled in the list
+ * @param translations Where the translations are appended
+ */
+void CompactDictionary::findTranslations(string_ref word1,
+                                         vector<string> &translations) const
+{
+    Cursor cursor;
+    bool found = seekWord(cursor, word1);
+
+    while(found && string_ref(cursor.entry.word1) == word1)
+    {
+        translations.push_back(cursor.entry.word2);
+        found = next(cursor);
+    }
+}
+
+
+/**
+ * Finds the entries whose first word starts with a prefix, in sorted order.
+ * @param max How many entries to return at most
+ * @param entries Where the entries are appended
+ * @return The number of entries appended
+ */
+size_t CompactDictionary::findPrefix(string_ref prefix, size_t max,
+                                     vector<DictionaryEntry> &entries) const
+{
+    Cursor cursor;
+    bool found = seekWord(cursor, prefix);
+
+    size_t numFound = 0;
+    while(found && numFound < max &&
+          string_ref(cursor.entry.word1).starts_with(prefix))
+    {
+        entries.push_back(cursor.entry);
+        numFound++;
+        found = next(cursor);
+    }
+
+    return numFound;
+}
+
+
+void CompactDictionary::clear()
+{
+    numEntries = 0;
+    blockSize = FRONT_CODING_BLOCK_SIZE;
+    blockOffsets.clear();
+    data = NULL;
+    dataSize = 0;
+    ownedData.clear();
+    mapping.reset();
+
+    listName.clear();
+    lang1.clear();
+    lang2.clear();
+}
+
+
+/**
+ * Positions a cursor so that the next entry it reads is the one at index.
+ * Decoding has to start from the beginning of the entry's block.
+ */
+void CompactDictionary::seek(Cursor &cursor, size_t index) const
+{
+    if(index > numEntries)
+        index = numEntries;
+
+    cursor.index = index - index % blockSize;
+    cursor.pos = cursor.end = NULL;
+
+    while(cursor.index < index && next(cursor))
+        ;
+
+    // A damaged block ends the scan early; make sure nothing else is read
+    if(cursor.index < index)
+        cursor.index = numEntries;
+}
+
+
+/**
+ * Reads entries until the first one whose first word is not less than a
+ * word, leaving it in cursor.entry.
+ * @return False if every word in the dictionary is less.
+ */
+bool CompactDictionary::seekWord(Cursor &cursor, string_ref word1) const
+{
+    // Find the first block which starts at or after the word. Entries
+    // before it all come before the word, except perhaps at the end of the
+    // block before it, so that block is where the scan starts.
+    size_t low = 0;
+    size_t high = blockOffsets.size();
+
+    while(low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+
+        if(firstWordOfBlock(middle).compare(word1) < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    seek(cursor, (low == 0) ? 0 : (low - 1) * blockSize);
+
+    while(next(cursor))
+    {
+        if(string_ref(cursor.entry.word1).compare(word1) >= 0)
+            return true;
+    }
+
+    return false;
+}
+
+
+/**
+ * Reads the entry at the cursor into cursor.entry.
+ * @return False at the end of the dictionary, or if the entry is damaged.
+ */
+bool CompactDictionary::next(Cursor &cursor) const
+{
+    if(cursor.index >= numEntries)
+        return false;
+
+    if(cursor.index % blockSize == 0)
+    {
+        size_t block = cursor.index / blockSize;
+        cursor.pos = data + blockOffsets[block];
+        cursor.end = blockEnd(block);
+    }
+
+    if(!readWord(cursor.pos, cursor.end, cursor.entry.word1) ||
+       !readWord(cursor.pos, cursor.end, cursor.entry.word2))
+    {
+        cursor.index = numEntries;
+        return false;
+    }
+
+    cursor.index++;
+    return true;
+}
+
+
+/**
+ * The first word of a block, which is always stored in full.
+ */
+string_ref CompactDictionary::firstWordOfBlock(size_t block) const
+{
+    const char *pos = data + blockOffsets[block];
+    const char *end = blockEnd(block);
+    size_t shared, length;
+
+    if(!readVarint(pos, end, shared) || !readVarint(pos, end, length) ||
+       (size_t)(end - pos) < length)
+        return string_ref();
+
+    return string_ref(pos, length);
+}
+
+
+/**
+ * Where a block's entries end, which is where the next block starts.
+ */
+const char* CompactDictionary::blockEnd(size_t block) const
+{
+    if(block + 1 < blockOffsets.size())
+        return data + blockOffsets[block + 1];
+
+    return data + dataSize;
+}
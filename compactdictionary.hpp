@@ -0,0 +1,89 @@
+/**
+ * @file compactdictionary.hpp
+ * @brief Header definitions for the CompactDictionary class.
+ * @author Alex Zirbel
+ */
+
+#ifndef COMPACTDICTIONARY_H
+#define COMPACTDICTIONARY_H
+
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+class QuizList;
+class MasterList;
+
+//! Marks the start of a compact dictionary file.
+#define COMPACT_DICTIONARY_MAGIC "WQCD"
+//! The version of the compact dictionary format written by saveToFile.
+#define COMPACT_DICTIONARY_VERSION 1
+
+//! How many entries share one index entry. Larger blocks compress better,
+//! smaller ones make looking up a single entry faster.
+#define FRONT_CODING_BLOCK_SIZE 16
+
+/**
+ * One pair of words read back from a CompactDictionary.
+ */
+struct DictionaryEntry
+{
+    std::string word1;
+    std::string word2;
+};
+
+class CompactDictionary : boost::noncopyable
+{
+size_t numEntries;
+size_t blockSize;
+
+//! Where each block starts in data. Each block begins with its first
+//! word written out in full, so the blocks can be binary searched.
+std::vector<boost::uint64_t> blockOffsets;
+
+//! The front-coded entries, either in ownedData or in the mapped file.
+const char *data;
+size_t dataSize;
+std::vector<char> ownedData;
+boost::shared_ptr<boost::interprocess::mapped_region> mapping;
+
+public:
+    std::string listName;
+    //! The languages of word1 and word2 in every entry.
+    std::string lang1;
+    std::string lang2;
+
+    CompactDictionary();
+
+    void build(const QuizList &list);
+    bool loadFromFile(std::string filename);
+    bool saveToFile(std::string filename) const;
+    void expand(MasterList &list) const;
+
+    size_t size() const;
+    size_t bytesUsed() const;
+
+    size_t getEntries(size_t first, size_t count,
+                      std::vector<DictionaryEntry> &entries) const;
+    size_t lowerBound(boost::string_ref word1) const;
+    void findTranslations(boost::string_ref word1,
+                          std::vector<std::string> &translations) const;
+    size_t findPrefix(boost::string_ref prefix, size_t max,
+                      std::vector<DictionaryEntry> &entries) const;
+
+private:
+    struct Cursor;
+
+    void clear();
+    void seek(Cursor &cursor, size_t index) const;
+    bool next(Cursor &cursor) const;
+    bool seekWord(Cursor &cursor, boost::string_ref word1) const;
+    boost::string_ref firstWordOfBlock(size_t block) const;
+    const char* blockEnd(size_t block) const;
+};
+
+#endif // COMPACTDICTIONARY_H
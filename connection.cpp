@@ -13,11 +13,14 @@
  */
 
 #include "connection.hpp"
+#include "casefold.hpp"
+#include "fieldscanner.hpp"
+
+#include <sstream>
 
 using namespace std;
 using namespace boost;
-using boost::lexical_cast;
-using boost::bad_lexical_cast;  // Used to catch bad lexical casts
+using boost::string_ref;
 
 /**
  * Declares an invalid connection with no data.
@@ -28,10 +31,10 @@ using boost::bad_lexical_cast;  // Used to catch bad lexical casts
  */
 Connection::Connection()
 {
-    word1 = "";
-    word2 = "";
-    lang1 = "";
-    lang2 = "";
+    word1 = WordPool::emptyWord();
+    word2 = WordPool::emptyWord();
+    lang1 = WordPool::emptyWord();
+    lang2 = WordPool::emptyWord();
     valid = false;
 }
 
@@ -40,21 +43,75 @@ Connection::Connection()
  * Initializes a connection. This is the only allowed way to add a new
  * connection. Upon initialization, this constructor orders the languages in
  * alphabetical order and checks for problems.
+ *
+ * The words are stored in the process-wide WordPool; connections which
+ * belong to a list should use the constructor taking the list's pool.
+ * @param myLang1 The first language. Does not have to be first alphabetically.
+ * @param myLang2 The second language.
+ * @param myWord1 The word in the language of myLang1
+ * @param myWord2 The word in the language of myLang2
+ */
+Connection::Connection(const string &myLang1, const string &myLang2,
+    const string &myWord1, const string &myWord2)
+{
+    init(WordPool::sharedPool(), myLang1, myLang2, myWord1, myWord2);
+}
+
+
+/**
+ * Initializes a connection whose languages and words are stored in the
+ * given pool.
+ * @param pool The pool which stores the words of this connection
  * @param myLang1 The first language. Does not have to be first alphabetically.
  * @param myLang2 The second language.
  * @param myWord1 The word in the language of myLang1
  * @param myWord2 The word in the language of myLang2
  */
-Connection::Connection(string myLang1, string myLang2,
-    string myWord1, string myWord2)
+Connection::Connection(WordPool &pool, const string &myLang1,
+    const string &myLang2, string_ref myWord1, string_ref myWord2)
+{
+    init(pool, myLang1, myLang2, myWord1, myWord2);
+}
+
+
+/**
+ * Rebuilds a connection from handles which are already stored in a pool and
+ * already in the correct order, such as a row of a QuizList.
+ * @param myLang1 The first language alphabetically
+ * @param myLang2 The second language alphabetically
+ * @param myWord1 The word in the language of myLang1
+ * @param myWord2 The word in the language of myLang2
+ * @param proficiency How well the user knows the word, from 0 to 100
+ * @param quizzed The last time the word was quizzed
+ */
+Connection::Connection(const string *myLang1, const string *myLang2,
+    const string *myWord1, const string *myWord2,
+    int proficiency, time_t quizzed)
+{
+    lang1 = myLang1;
+    lang2 = myLang2;
+    word1 = myWord1;
+    word2 = myWord2;
+    userProficiency = proficiency;
+    lastQuizzed = quizzed;
+    valid = true;
+}
+
+
+/**
+ * Shared body of the constructors: checks the languages and stores the
+ * words with default statistics.
+ */
+void Connection::init(WordPool &pool, const string &myLang1,
+    const string &myLang2, string_ref myWord1, string_ref myWord2)
 {
     // Languages must be different, ignoring case
-    if(boost::iequals(myLang1, myLang2))
+    if(caseInsensitiveEquals(myLang1, myLang2))
     {
         throw new InvalidLanguageException;
     }
 
-    storeInCorrectOrder(myLang1, myLang2, myWord1, myWord2);
+    storeInCorrectOrder(pool, myLang1, myLang2, myWord1, myWord2);
 
     userProficiency = DEFAULT_PROFICIENCY;
     lastQuizzed = (time_t) 0;
@@ -64,34 +121,22 @@ Connection::Connection(string myLang1, string myLang2,
 
 
 /**
- * Used in conjunction with blank connection instantiation, sets Connection
- * data as parsed from the line.  This should be the only method used to
- * read data from lines anywhere in the program.
- * @param line The string to read data from, assumed to store data in the
- *      following format: <word1>\t<word2>\t<proficiency>\t<lastquizzed>
- * @param myLang1 The language corresponding to the connection's first word
- * @param myLang2 The language corresponding to the connection's second word
+ * Loads a connection from a line, storing its words in the process-wide
+ * WordPool. See the overload taking a pool.
  */
-bool Connection::loadFromLine(string line, string myLang1, string myLang2)
+bool Connection::loadFromLine(const string &line, const string &myLang1,
+                              const string &myLang2, WordPool &pool)
 {
-    string myWord1, myWord2;
-
-    // Tokenize based on tab characters
-    char_separator <char> sep("\t");
-    tokenizer<char_separator <char> > tokens(line, sep);
-    tokenizer<char_separator <char> >::iterator itr = tokens.begin();
+    FieldScanner fields(line);
+    string_ref myWord1, myWord2, field;
 
     // Make sure there are at least two tokens; ignore any additional
-    myWord1 = *itr;
-    itr++;
-    if(itr == tokens.end())
+    if(!fields.next(myWord1) || !fields.next(myWord2))
         return false;
-    myWord2 = *itr;
 
-    storeInCorrectOrder(myLang1, myLang2, myWord1, myWord2);
+    storeInCorrectOrder(pool, myLang1, myLang2, myWord1, myWord2);
 
-    itr++;
-    if(itr == tokens.end())
+    if(!fields.next(field))
     {
         userProficiency = DEFAULT_PROFICIENCY;
         lastQuizzed = 0;
@@ -100,17 +145,10 @@ bool Connection::loadFromLine(string line, string myLang1, string myLang2)
     }
 
     // Get the user proficiency, or return a problem load
-    try
-    {
-        userProficiency = lexical_cast<int>(*itr);
-    }
-    catch(bad_lexical_cast &)
-    {
+    if(!parseInt(field, userProficiency))
         return false;
-    }
 
-    itr++;
-    if(itr == tokens.end())
+    if(!fields.next(field))
     {
         lastQuizzed = 0;
         valid = true;
@@ -118,14 +156,10 @@ bool Connection::loadFromLine(string line, string myLang1, string myLang2)
     }
 
     // Get the last time quizzed, or return a problem load
-    try
-    {
-        lastQuizzed = (time_t) lexical_cast<unsigned int>(*itr);
-    }
-    catch(bad_lexical_cast &)
-    {
+    unsigned int quizzed;
+    if(!parseUnsigned(field, quizzed))
         return false;
-    }
+    lastQuizzed = (time_t) quizzed;
 
     // If the whole load worked, the connection is valid.
     valid = true;
@@ -138,24 +172,64 @@ bool Connection::loadFromLine(string line, string myLang1, string myLang2)
  * file.  Should be the only method used to push Connection data to a
  * file.
  */
-string Connection::exportToLine()
+string Connection::exportToLine() const
 {
     stringstream line;
 
-    line << word1 << "\t" << word2 << "\t" << userProficiency << "\t"
+    line << *word1 << "\t" << *word2 << "\t" << userProficiency << "\t"
         << ((unsigned int) lastQuizzed);
     
     return line.str();
 }
 
 
+/**
+ * Accessor for userProficiency
+ * @return userProficiency How well the user knows the word, from 0 to 100
+ */
+int Connection::getUserProficiency() const
+{
+    return userProficiency;
+}
+
+
+/**
+ * Accessor for lastQuizzed
+ * @return lastQuizzed The last time this connection was quizzed on
+ */
+int Connection::getLastQuizzed() const
+{
+    return (int) lastQuizzed;
+}
+
+
+/**
+ * Sets how well the user knows the word.
+ * @param proficiency A rating from 0 to 100
+ */
+void Connection::setUserProficiency(int proficiency)
+{
+    userProficiency = proficiency;
+}
+
+
+/**
+ * Sets the last time this connection was quizzed on.
+ * @param quizzed The time of the last quiz
+ */
+void Connection::setLastQuizzed(time_t quizzed)
+{
+    lastQuizzed = quizzed;
+}
+
+
 /**
  * Accessor for lang1
  * @return lang1 The first language alphabetically
  */
-string Connection::getLang1()
+const string& Connection::getLang1() const
 {
-    return lang1;
+    return *lang1;
 }
 
 
@@ -163,9 +237,9 @@ string Connection::getLang1()
  * Accessor for lang2
  * @return lang2 The second language alphabetically
  */
-string Connection::getLang2()
+const string& Connection::getLang2() const
 {
-    return lang2;
+    return *lang2;
 }
 
 
@@ -173,9 +247,9 @@ string Connection::getLang2()
  * Accessor for word1
  * @return word1 The word corresponding to the first language
  */
-string Connection::getWord1()
+const string& Connection::getWord1() const
 {
-    return word1;
+    return *word1;
 }
 
 
@@ -183,7 +257,25 @@ string Connection::getWord1()
  * Accessor for word2
  * @return word2 The word corresponding to the second language
  */
-string Connection::getWord2()
+const string& Connection::getWord2() const
+{
+    return *word2;
+}
+
+
+/**
+ * The pooled handle of word1, for lists which store connections by handle.
+ */
+const string* Connection::getWord1Handle() const
+{
+    return word1;
+}
+
+
+/**
+ * The pooled handle of word2, for lists which store connections by handle.
+ */
+const string* Connection::getWord2Handle() const
 {
     return word2;
 }
@@ -198,25 +290,26 @@ string Connection::getWord2()
  *  languages will always be compared case insensitive.
  * @return true If languages and words are both the same, false otherwise.
  */
-bool Connection::basicEquals(Connection conn2, bool caseSensitive)
+bool Connection::basicEquals(const Connection &conn2,
+                             bool caseSensitive) const
 {
-    if(!boost::iequals(lang1, conn2.getLang1()))
+    if(!caseInsensitiveEquals(*lang1, conn2.getLang1()))
         return false;
-    if(!boost::iequals(lang2, conn2.getLang2()))
+    if(!caseInsensitiveEquals(*lang2, conn2.getLang2()))
         return false;
 
     if(caseSensitive)
     {
-        if(!boost::equals(word1, conn2.getWord1()))
+        if(!boost::equals(*word1, conn2.getWord1()))
             return false;
-        if(!boost::equals(word2, conn2.getWord2()))
+        if(!boost::equals(*word2, conn2.getWord2()))
             return false;
     }
     else
     {
-        if(!boost::iequals(word1, conn2.getWord1()))
+        if(!caseInsensitiveEquals(*word1, conn2.getWord1()))
             return false;
-        if(!boost::iequals(word2, conn2.getWord2()))
+        if(!caseInsensitiveEquals(*word2, conn2.getWord2()))
             return false;
     }
 
@@ -224,11 +317,26 @@ bool Connection::basicEquals(Connection conn2, bool caseSensitive)
 }
 
 
+/**
+ * Moves the connection's languages and words into another pool, keeping
+ * its statistics. Used when a connection is added to a list which stores
+ * its words in a different pool than the one the connection was built with.
+ * @param pool The pool the connection should refer to from now on
+ */
+void Connection::internInto(WordPool &pool)
+{
+    lang1 = pool.intern(*lang1);
+    lang2 = pool.intern(*lang2);
+    word1 = pool.intern(*word1);
+    word2 = pool.intern(*word2);
+}
+
+
 /**
  * An accessor the check whether the connection is valid.
  * @return True for a valid connection, false otherwise.
  */
-bool Connection::isValid()
+bool Connection::isValid() const
 {
     return valid;
 }
@@ -237,27 +345,28 @@ bool Connection::isValid()
 /**
  * Given languages and words which correspond (myLang1 is the language
  * of myWord1), stores the data with lang1 being first alphabetically.
+ * @param pool The pool to intern the languages and words into
  */
-void Connection::storeInCorrectOrder(string myLang1, string myLang2,
-                                     string myWord1, string myWord2)
+void Connection::storeInCorrectOrder(WordPool &pool, const string &myLang1,
+    const string &myLang2, string_ref myWord1, string_ref myWord2)
 {
     // Ensure languages are sorted alphabetically when stored
     if(boost::algorithm::lexicographical_compare
         (myLang1, myLang2, boost::is_iless()))
     {
         // Languages were specified in order
-        lang1 = myLang1;
-        lang2 = myLang2;
-        word1 = myWord1;
-        word2 = myWord2;
+        lang1 = pool.intern(myLang1);
+        lang2 = pool.intern(myLang2);
+        word1 = pool.intern(myWord1);
+        word2 = pool.intern(myWord2);
     }
     else
     {
         // Swap words and languages
-        lang1 = myLang2;
-        lang2 = myLang1;
-        word1 = myWord2;
-        word2 = myWord1;
+        lang1 = pool.intern(myLang2);
+        lang2 = pool.intern(myLang1);
+        word1 = pool.intern(myWord2);
+        word2 = pool.intern(myWord1);
     }
 }
 
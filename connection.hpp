@@ -8,10 +8,10 @@
 #define CONNECTION_H
 
 #include <iostream>
-#include <boost/tokenizer.hpp>
-#include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/utility/string_ref.hpp>
 #include "exceptions.hpp"
+#include "wordpool.hpp"
 
 /* A newly loaded word is assigned this proficiency. */
 #define DEFAULT_PROFICIENCY 30
@@ -22,14 +22,16 @@ class Connection
 //! Keeps track of whether a connection has been verified or not.
 bool valid;
 
+// Languages and words are handles into a WordPool, which owns the text.
+
 //! Lang1 is the first language alphabetically.
-std::string lang1;
+const std::string *lang1;
 //! Lang2 is the second language alphabetically.
-std::string lang2;
+const std::string *lang2;
 
 // The word itself and its translation
-std::string word1;
-std::string word2;
+const std::string *word1;
+const std::string *word2;
 
 //! A rating from 0 to 100, how well the user knows the word.
 int userProficiency;
@@ -43,25 +45,42 @@ time_t lastQuizzed;
 
 public:
     Connection();
-    Connection(std::string myLang1, std::string myLang2,
-               std::string myWord1, std::string myWord2);
+    Connection(const std::string &myLang1, const std::string &myLang2,
+               const std::string &myWord1, const std::string &myWord2);
+    Connection(WordPool &pool, const std::string &myLang1,
+               const std::string &myLang2, boost::string_ref myWord1,
+               boost::string_ref myWord2);
+    Connection(const std::string *myLang1, const std::string *myLang2,
+               const std::string *myWord1, const std::string *myWord2,
+               int proficiency, time_t quizzed);
 
-    bool loadFromLine(std::string line, std::string myLang1,
-                      std::string myLang2);
-    std::string exportToLine();
+    bool loadFromLine(const std::string &line, const std::string &myLang1,
+                      const std::string &myLang2);
+    bool loadFromLine(const std::string &line, const std::string &myLang1,
+                      const std::string &myLang2, WordPool &pool);
+    std::string exportToLine() const;
 
-    int getUserProficiency();
-    int getLastQuizzed();
-    std::string getLang1();
-    std::string getLang2();
-    std::string getWord1();
-    std::string getWord2();
-    bool basicEquals(Connection conn2, bool caseSenstive);
-    bool isValid();
+    int getUserProficiency() const;
+    int getLastQuizzed() const;
+    void setUserProficiency(int proficiency);
+    void setLastQuizzed(time_t quizzed);
+    const std::string& getLang1() const;
+    const std::string& getLang2() const;
+    const std::string& getWord1() const;
+    const std::string& getWord2() const;
+    const std::string* getWord1Handle() const;
+    const std::string* getWord2Handle() const;
+    bool basicEquals(const Connection &conn2, bool caseSenstive) const;
+    void internInto(WordPool &pool);
+    bool isValid() const;
 
 private:
-    void storeInCorrectOrder(std::string myLang1, std::string myLang2,
-         std::string myWord1, std::string myWord2);
+    void init(WordPool &pool, const std::string &myLang1,
+              const std::string &myLang2, boost::string_ref myWord1,
+              boost::string_ref myWord2);
+    void storeInCorrectOrder(WordPool &pool, const std::string &myLang1,
+         const std::string &myLang2, boost::string_ref myWord1,
+         boost::string_ref myWord2);
 };
 
 #endif // CONNECTION_H
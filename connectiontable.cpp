@@ -0,0 +1,242 @@
+/**
+ * @file connectiontable.cpp
+ * @brief Stores the connections of a list column by column.
+ * @author Alex Zirbel
+ *
+ * A QuizList keeps its connections here rather than as a list of Connection
+ * objects. Each field has its own contiguous array, indexed by row, so that
+ * walking the whole list reads memory in order, and a pass over the
+ * statistics (scheduling, sorting) never loads the words at all. Rows are
+ * plain indices: they stay valid as rows are appended, and only change when
+ * the table is reordered.
+ *
+ * The languages are not stored per row, since every connection in a list
+ * shares the list's languages.
+ *
+ * Copying a table is cheap: the copies share their columns until one of
+ * them is changed, and only then is that one given columns of its own. A
+ * profile can be snapshotted for saving without copying any rows, and the
+ * quiz can carry on changing the live table while the snapshot is written.
+ */
+
+#include "connectiontable.hpp"
+#include "bufferedwriter.hpp"
+#include "arena.hpp"
+
+#include <algorithm>
+
+using namespace std;
+
+ConnectionTable::ConnectionTable() : columns(new Columns)
+{
+}
+
+
+/**
+ * The number of rows in the table.
+ */
+size_t ConnectionTable::size() const
+{
+    return columns->proficiencies.size();
+}
+
+
+bool ConnectionTable::empty() const
+{
+    return columns->proficiencies.empty();
+}
+
+
+void ConnectionTable::clear()
+{
+    // Leave any copies their rows rather than copying rows about to go
+    columns.reset(new Columns);
+}
+
+
+/**
+ * Makes room for a number of rows, so that a bulk load does not reallocate
+ * the columns as it goes.
+ */
+void ConnectionTable::reserve(size_t rows)
+{
+    Columns &data = modify();
+
+    data.word1s.reserve(rows);
+    data.word2s.reserve(rows);
+    data.proficiencies.reserve(rows);
+    data.lastQuizzed.reserve(rows);
+}
+
+
+/**
+ * Adds a row to the end of the table.
+ * @param word1 Handle to the word in the list's first language
+ * @param word2 Handle to the word in the list's second language
+ * @param proficiency How well the user knows the word, from 0 to 100
+ * @param quizzed The last time the word was quizzed
+ * @return The index of the new row
+ */
+size_t ConnectionTable::append(const string *word1, const string *word2,
+                               int proficiency, time_t quizzed)
+{
+    Columns &data = modify();
+
+    data.word1s.push_back(word1);
+    data.word2s.push_back(word2);
+    data.proficiencies.push_back(proficiency);
+    data.lastQuizzed.push_back(quizzed);
+
+    return data.proficiencies.size() - 1;
+}
+
+
+const string& ConnectionTable::getWord1(size_t row) const
+{
+    return *columns->word1s[row];
+}
+
+
+const string& ConnectionTable::getWord2(size_t row) const
+{
+    return *columns->word2s[row];
+}
+
+
+const string* ConnectionTable::getWord1Handle(size_t row) const
+{
+    return columns->word1s[row];
+}
+
+
+const string* ConnectionTable::getWord2Handle(size_t row) const
+{
+    return columns->word2s[row];
+}
+
+
+int ConnectionTable::getUserProficiency(size_t row) const
+{
+    return columns->proficiencies[row];
+}
+
+
+time_t ConnectionTable::getLastQuizzed(size_t row) const
+{
+    return columns->lastQuizzed[row];
+}
+
+
+void ConnectionTable::setUserProficiency(size_t row, int proficiency)
+{
+    modify().proficiencies[row] = proficiency;
+}
+
+
+void ConnectionTable::setLastQuizzed(size_t row, time_t quizzed)
+{
+    modify().lastQuizzed[row] = quizzed;
+}
+
+
+/**
+ * The proficiency of every row, for passes which only need statistics.
+ */
+const vector<int>& ConnectionTable::proficiencyColumn() const
+{
+    return columns->proficiencies;
+}
+
+
+/**
+ * The last quizzed time of every row, for passes which only need statistics.
+ */
+const vector<time_t>& ConnectionTable::lastQuizzedColumn() const
+{
+    return columns->lastQuizzed;
+}
+
+
+/**
+ * The memory the columns take up, including room reserved for more rows.
+ * Columns shared with copies of the table are counted in full.
+ */
+size_t ConnectionTable::bytesUsed() const
+{
+    const Columns &data = *columns;
+
+    return heapBlockBytes(sizeof(Columns)) +
+           heapBlockBytes(data.word1s.capacity() * sizeof(const string*)) +
+           heapBlockBytes(data.word2s.capacity() * sizeof(const string*)) +
+           heapBlockBytes(data.proficiencies.capacity() * sizeof(int)) +
+           heapBlockBytes(data.lastQuizzed.capacity() * sizeof(time_t));
+}
+
+
+/**
+ * Rearranges the rows, so that new row i holds what was in row order[i].
+ * Sorting the table means sorting a vector of row indices on one column and
+ * then reordering every column once.
+ * @param order A permutation of the row indices
+ */
+void ConnectionTable::reorder(const vector<size_t> &order)
+{
+    // Every row moves, so build new columns rather than copying shared ones
+    // first and then moving them around
+    boost::shared_ptr<Columns> reordered(new Columns);
+
+    reorderColumn(columns->word1s, order, reordered->word1s);
+    reorderColumn(columns->word2s, order, reordered->word2s);
+    reorderColumn(columns->proficiencies, order, reordered->proficiencies);
+    reorderColumn(columns->lastQuizzed, order, reordered->lastQuizzed);
+
+    columns = reordered;
+}
+
+
+/**
+ * Writes every row as a line in the format read by Connection::loadFromLine,
+ * straight from the columns.
+ * @param out Where the lines are written
+ */
+void ConnectionTable::writeRows(BufferedWriter &out) const
+{
+    const Columns &data = *columns;
+
+    for(size_t row = 0; row < data.proficiencies.size(); row++)
+    {
+        out.write(*data.word1s[row]);
+        out.put('\t');
+        out.write(*data.word2s[row]);
+        out.put('\t');
+        out.writeInt(data.proficiencies[row]);
+        out.put('\t');
+        out.writeUnsigned((unsigned int) data.lastQuizzed[row]);
+        out.put('\n');
+    }
+}
+
+
+/**
+ * The columns, ready to be changed. If a copy of the table still shares
+ * them, this table is given its own copy first.
+ */
+ConnectionTable::Columns& ConnectionTable::modify()
+{
+    if(!columns.unique())
+        columns.reset(new Columns(*columns));
+
+    return *columns;
+}
+
+
+template <typename T>
+void ConnectionTable::reorderColumn(const vector<T> &column,
+                                    const vector<size_t> &order,
+                                    vector<T> &reordered)
+{
+    reordered.reserve(column.size());
+
+    for(size_t i = 0; i < order.size(); i++)
+        reordered.push_back(column[order[i]]);
+}
@@ -0,0 +1,67 @@
+/**
+ * @file connectiontable.hpp
+ * @brief Header definitions for the ConnectionTable class.
+ * @author Alex Zirbel
+ */
+
+#ifndef CONNECTIONTABLE_H
+#define CONNECTIONTABLE_H
+
+#include <string>
+#include <vector>
+#include <ctime>
+#include <boost/shared_ptr.hpp>
+
+class BufferedWriter;
+
+class ConnectionTable
+{
+// One entry per row in each column. Words are handles into the owning
+// list's WordPool, kept apart from the statistics so that scans over the
+// statistics never touch word data.
+struct Columns
+{
+    std::vector<const std::string*> word1s;
+    std::vector<const std::string*> word2s;
+    std::vector<int> proficiencies;
+    std::vector<time_t> lastQuizzed;
+};
+
+//! Shared between copies of the table until one of them changes it.
+boost::shared_ptr<Columns> columns;
+
+public:
+    ConnectionTable();
+
+    size_t size() const;
+    bool empty() const;
+    void clear();
+    void reserve(size_t rows);
+    size_t append(const std::string *word1, const std::string *word2,
+                  int proficiency, time_t quizzed);
+
+    const std::string& getWord1(size_t row) const;
+    const std::string& getWord2(size_t row) const;
+    const std::string* getWord1Handle(size_t row) const;
+    const std::string* getWord2Handle(size_t row) const;
+    int getUserProficiency(size_t row) const;
+    time_t getLastQuizzed(size_t row) const;
+    void setUserProficiency(size_t row, int proficiency);
+    void setLastQuizzed(size_t row, time_t quizzed);
+
+    const std::vector<int>& proficiencyColumn() const;
+    const std::vector<time_t>& lastQuizzedColumn() const;
+
+    void reorder(const std::vector<size_t> &order);
+    void writeRows(BufferedWriter &out) const;
+    size_t bytesUsed() const;
+
+private:
+    Columns& modify();
+    template <typename T>
+    static void reorderColumn(const std::vector<T> &column,
+                              const std::vector<size_t> &order,
+                              std::vector<T> &reordered);
+};
+
+#endif // CONNECTIONTABLE_H
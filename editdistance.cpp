@@ -0,0 +1,195 @@
+/**
+ * @file editdistance.cpp
+ * @brief Decides whether an answer is within a few typos of a word.
+ * @author Alex Zirbel
+ *
+ * A TypoMatcher is built once for the answer the user typed and is then
+ * tested against every translation which would have been accepted. The
+ * distance used is the Levenshtein distance: the number of characters
+ * inserted, deleted or replaced. It is counted in bytes, so a mistyped
+ * letter outside ASCII may count as two typos.
+ *
+ * Most words are ruled out before any distance is computed: if their
+ * lengths differ by more than the allowed typos, or if their character
+ * histograms differ by more than two per typo (one edit moves at most two
+ * counts), they cannot be close enough. The distance itself is computed
+ * with Myers' bit-parallel algorithm, which handles a whole column of the
+ * edit distance table in a few word operations per character, and gives up
+ * as soon as the remaining characters could not bring the distance back
+ * within bounds. Answers longer than 64 bytes use a banded table instead.
+ */
+
+#include "editdistance.hpp"
+
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+using boost::string_ref;
+using boost::uint64_t;
+
+/**
+ * Prepares to compare words against an answer.
+ * @param myAnswer The answer, case folded if case should be ignored
+ * @param myMaxTypos How many edits are allowed
+ */
+TypoMatcher::TypoMatcher(const string &myAnswer, int myMaxTypos)
+{
+    answer = myAnswer;
+    maxTypos = myMaxTypos;
+
+    for(int c = 0; c < 256; c++)
+        positions[c] = 0;
+    for(int b = 0; b < TYPO_HISTOGRAM_BUCKETS; b++)
+        histogram[b] = 0;
+
+    for(size_t i = 0; i < answer.size(); i++)
+    {
+        unsigned char c = answer[i];
+
+        if(i < 64)
+            positions[c] |= (uint64_t) 1 << i;
+        histogram[c % TYPO_HISTOGRAM_BUCKETS]++;
+    }
+}
+
+
+/**
+ * Whether a word is within maxTypos edits of the answer.
+ */
+bool TypoMatcher::matches(string_ref word) const
+{
+    if(maxTypos < 0)
+        return false;
+
+    if(abs((int) word.size() - (int) answer.size()) > maxTypos)
+        return false;
+
+    if(!histogramsClose(word))
+        return false;
+
+    if(answer.size() <= 64)
+        return bitParallelDistance(word) <= maxTypos;
+    else
+        return bandedDistance(word) <= maxTypos;
+}
+
+
+/**
+ * Whether the word's histogram is close enough to the answer's for the
+ * word to possibly be within maxTypos edits.
+ */
+bool TypoMatcher::histogramsClose(string_ref word) const
+{
+    int difference[TYPO_HISTOGRAM_BUCKETS];
+
+    for(int b = 0; b < TYPO_HISTOGRAM_BUCKETS; b++)
+        difference[b] = histogram[b];
+
+    for(size_t i = 0; i < word.size(); i++)
+        difference[(unsigned char) word[i] % TYPO_HISTOGRAM_BUCKETS]--;
+
+    int total = 0;
+    for(int b = 0; b < TYPO_HISTOGRAM_BUCKETS; b++)
+        total += abs(difference[b]);
+
+    return total <= 2 * maxTypos;
+}
+
+
+/**
+ * Myers' bit-parallel edit distance, for answers of at most 64 bytes.
+ * Bit i of the vertical deltas describes row i + 1 of the current column.
+ * @return The distance, or maxTypos + 1 if it is certainly larger.
+ */
+int TypoMatcher::bitParallelDistance(string_ref word) const
+{
+    size_t length = answer.size();
+    if(length == 0)
+        return (int) word.size();
+
+    uint64_t lastRow = (uint64_t) 1 << (length - 1);
+    uint64_t plusVertical = ~(uint64_t) 0;
+    uint64_t minusVertical = 0;
+    int distance = (int) length;
+
+    for(size_t j = 0; j < word.size(); j++)
+    {
+        uint64_t equal = positions[(unsigned char) word[j]];
+        uint64_t crossVertical = equal | minusVertical;
+        uint64_t crossHorizontal = (((equal & plusVertical) + plusVertical) ^
+                                    plusVertical) | equal;
+        uint64_t plusHorizontal = minusVertical |
+                                  ~(crossHorizontal | plusVertical);
+        uint64_t minusHorizontal = plusVertical & crossHorizontal;
+
+        if(plusHorizontal & lastRow)
+            distance++;
+        else if(minusHorizontal & lastRow)
+            distance--;
+
+        // The top row of the table counts up, so shift in a plus
+        plusHorizontal = (plusHorizontal << 1) | 1;
+        minusHorizontal <<= 1;
+        plusVertical = minusHorizontal | ~(crossVertical | plusHorizontal);
+        minusVertical = plusHorizontal & crossVertical;
+
+        // Each remaining character can lower the distance by one at most
+        if(distance - (int) (word.size() - j - 1) > maxTypos)
+            return maxTypos + 1;
+    }
+
+    return distance;
+}
+
+
+/**
+ * The edit distance computed with a table, only filling in cells within
+ * maxTypos of the diagonal, for answers too long for bitParallelDistance.
+ * @return The distance, or maxTypos + 1 if it is certainly larger.
+ */
+int TypoMatcher::bandedDistance(string_ref word) const
+{
+    int outOfBand = maxTypos + 1;
+    size_t rows = answer.size();
+    vector<int> previous(rows + 1), current(rows + 1);
+
+    for(size_t i = 0; i <= rows; i++)
+        previous[i] = ((int) i > maxTypos) ? outOfBand : (int) i;
+
+    for(size_t j = 1; j <= word.size(); j++)
+    {
+        int best = outOfBand;
+        current[0] = ((int) j > maxTypos) ? outOfBand : (int) j;
+
+        for(size_t i = 1; i <= rows; i++)
+        {
+            if(abs((int) i - (int) j) > maxTypos)
+            {
+                current[i] = outOfBand;
+                continue;
+            }
+
+            int cost = (answer[i - 1] == word[j - 1]) ? 0 : 1;
+            int value = previous[i - 1] + cost;
+            if(previous[i] + 1 < value)
+                value = previous[i] + 1;
+            if(current[i - 1] + 1 < value)
+                value = current[i - 1] + 1;
+            if(value > outOfBand)
+                value = outOfBand;
+
+            current[i] = value;
+            if(value < best)
+                best = value;
+        }
+
+        // Every path to the end passes through this column
+        if(best > maxTypos)
+            return outOfBand;
+
+        previous.swap(current);
+    }
+
+    return previous[rows];
+}
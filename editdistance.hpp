@@ -0,0 +1,40 @@
+/**
+ * @file editdistance.hpp
+ * @brief Header definitions for the TypoMatcher class.
+ * @author Alex Zirbel
+ */
+
+#ifndef EDITDISTANCE_H
+#define EDITDISTANCE_H
+
+#include <string>
+#include <boost/cstdint.hpp>
+#include <boost/utility/string_ref.hpp>
+
+//! Buckets in the character histograms used to rule words out quickly.
+#define TYPO_HISTOGRAM_BUCKETS 64
+
+class TypoMatcher
+{
+//! The word the user typed.
+std::string answer;
+//! How many single-character edits are forgiven.
+int maxTypos;
+
+//! For each byte value, the positions in the answer where it occurs.
+boost::uint64_t positions[256];
+//! How often bytes occur in the answer, by bucket.
+int histogram[TYPO_HISTOGRAM_BUCKETS];
+
+public:
+    TypoMatcher(const std::string &myAnswer, int myMaxTypos);
+
+    bool matches(boost::string_ref word) const;
+
+private:
+    bool histogramsClose(boost::string_ref word) const;
+    int bitParallelDistance(boost::string_ref word) const;
+    int bandedDistance(boost::string_ref word) const;
+};
+
+#endif // EDITDISTANCE_H
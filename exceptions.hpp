@@ -21,8 +21,9 @@
  * Handles all bad file readings. This is the best way to show that a
  * constructor failed, which may be the case when loading dictionaries.
  */
-class LoadFileException
+class LoadFileException : public std::exception
 {
+public:
     virtual const char* what() const throw()
     {
         return "Unable to load dictionary file.";
@@ -32,8 +33,9 @@ class LoadFileException
 /**
  * Handles the case when a requested profile does not exist.
  */
-class NoSuchProfileException
+class NoSuchProfileException : public std::exception
 {
+public:
     virtual const char* what() const throw()
     {
         return "No such user profile exists.";
@@ -43,8 +45,9 @@ class NoSuchProfileException
 /**
  * Handles cases where the username does not match username constraints.
  */
-class InvalidUsernameException
+class InvalidUsernameException : public std::exception
 {
+public:
     virtual const char* what() const throw()
     {
         return "The username specified is invalid.";
@@ -54,8 +57,9 @@ class InvalidUsernameException
 /**
  * Handles cases where the profile manager was requested, but not initialized
  */
-class InvalidProfileManagerException
+class InvalidProfileManagerException : public std::exception
 {
+public:
     virtual const char* what() const throw()
     {
         return "ProfileManager called, but was not instantiated correctly.";
@@ -65,8 +69,9 @@ class InvalidProfileManagerException
 /**
  * Handles cases where the user profile has not been initialized properly.
  */
-class InvalidUserProfileException
+class InvalidUserProfileException : public std::exception
 {
+public:
     virtual const char* what() const throw()
     {
         return "The UserProfile was not marked as valid; bad instantiation.";
@@ -78,8 +83,9 @@ class InvalidUserProfileException
  * For example, if the languages a word translates from and to are the same,
  * this exception will be thrown because a language must be invalid.
  */
-class InvalidLanguageException
+class InvalidLanguageException : public std::exception
 {
+public:
     virtual const char* what() const throw()
     {
         return "One or more languages specified are invalid.";
@@ -91,13 +97,28 @@ class InvalidLanguageException
  * number. The home language must describe language 1 or 2 by being set
  * to the short int 1 or 2.
  */
-class InvalidHomeLanguageException
+class InvalidHomeLanguageException : public std::exception
 {
+public:
     virtual const char* what() const throw()
     {
         return "The home language was set to a value not equal to 1 or 2.";
     }
 };
 
+/**
+ * Signals that a quiz was asked about its current prompt when there is none:
+ * before the first prompt, once the prompt has been answered, or once the
+ * quiz is over.
+ */
+class NoPromptException : public std::exception
+{
+public:
+    virtual const char* what() const throw()
+    {
+        return "The quiz has no prompt waiting for an answer.";
+    }
+};
+
 
 #endif // EXCEPTIONS_H
@@ -0,0 +1,107 @@
+/**
+ * @file fieldscanner.cpp
+ * @brief Parses the numbers in fields found by a FieldScanner.
+ * @author Alex Zirbel
+ *
+ * Every file the program reads is made of tab-separated fields, and the
+ * numbers in them are parsed straight from views into the line. Like
+ * boost::lexical_cast, the whole field must be the number, with no spaces,
+ * and numbers out of range are rejected; unlike it, nothing is allocated and
+ * nothing is thrown.
+ */
+
+#include "fieldscanner.hpp"
+
+#include <climits>
+
+using boost::string_ref;
+
+/**
+ * Parses the digits of a field into an unsigned number no larger than limit.
+ * @return False if the field is empty, has anything but digits, or is too
+ *  large.
+ */
+static bool parseDigits(const char *pos, const char *end, unsigned long limit,
+                        unsigned long &value)
+{
+    if(pos == end)
+        return false;
+
+    value = 0;
+    for(; pos != end; pos++)
+    {
+        unsigned int digit = (unsigned char) *pos - '0';
+        if(digit > 9)
+            return false;
+
+        if(value > (limit - digit) / 10)
+            return false;
+
+        value = value * 10 + digit;
+    }
+
+    return true;
+}
+
+/**
+ * Parses a whole field as a signed integer, with an optional sign.
+ * @param text The field
+ * @param value Set to the number, only if the field is valid
+ * @return True if the field was a number in the range of an int
+ */
+bool parseInt(string_ref text, int &value)
+{
+    const char *pos = text.data();
+    const char *end = text.data() + text.size();
+    bool negative = false;
+
+    if(pos != end && (*pos == '-' || *pos == '+'))
+    {
+        negative = (*pos == '-');
+        pos++;
+    }
+
+    unsigned long limit = negative ? (unsigned long) INT_MAX + 1 : INT_MAX;
+    unsigned long magnitude;
+    if(!parseDigits(pos, end, limit, magnitude))
+        return false;
+
+    if(negative)
+        value = (magnitude == (unsigned long) INT_MAX + 1) ?
+                INT_MIN : -(int) magnitude;
+    else
+        value = (int) magnitude;
+
+    return true;
+}
+
+/**
+ * Parses a whole field as an unsigned integer, with an optional sign. As
+ * with boost::lexical_cast, which the files were once read with, a minus
+ * sign wraps the number around, so "-1" is the largest unsigned int.
+ * @param text The field
+ * @param value Set to the number, only if the field is valid
+ * @return True if the field was a number in the range of an unsigned int
+ */
+bool parseUnsigned(string_ref text, unsigned int &value)
+{
+    const char *pos = text.data();
+    const char *end = text.data() + text.size();
+    bool negative = false;
+
+    if(pos != end && (*pos == '-' || *pos == '+'))
+    {
+        negative = (*pos == '-');
+        pos++;
+    }
+
+    unsigned long magnitude;
+    if(!parseDigits(pos, end, UINT_MAX, magnitude))
+        return false;
+
+    value = (unsigned int) magnitude;
+    if(negative)
+        value = 0u - value;
+
+    return true;
+}
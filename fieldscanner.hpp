@@ -0,0 +1,71 @@
+/**
+ * @file fieldscanner.hpp
+ * @brief Header definitions for the FieldScanner class and number parsing.
+ * @author Alex Zirbel
+ */
+
+#ifndef FIELDSCANNER_H
+#define FIELDSCANNER_H
+
+#include <cstring>
+#include <boost/utility/string_ref.hpp>
+
+/**
+ * Splits one line into its tab-separated fields without copying them. Runs
+ * of tabs count as one separator and empty fields are skipped, so a line
+ * with nothing but tabs has no fields at all.
+ */
+class FieldScanner
+{
+const char *pos;
+const char *end;
+
+public:
+    FieldScanner(boost::string_ref line)
+    {
+        pos = line.data();
+        end = line.data() + line.size();
+    }
+
+    FieldScanner(const char *lineBegin, const char *lineEnd)
+    {
+        pos = lineBegin;
+        end = lineEnd;
+    }
+
+    /**
+     * Finds the next field of the line.
+     * @param field Set to a view of the field, into the scanned line
+     * @return False if the line has no more fields.
+     */
+    bool next(boost::string_ref &field)
+    {
+        while(pos != end && *pos == '\t')
+            pos++;
+
+        if(pos == end)
+            return false;
+
+        const char *tab = (const char*) memchr(pos, '\t', end - pos);
+        const char *fieldEnd = (tab == NULL) ? end : tab;
+
+        field = boost::string_ref(pos, fieldEnd - pos);
+        pos = fieldEnd;
+        return true;
+    }
+};
+
+/**
+ * Finds the end of the line starting at pos.
+ * @return A pointer to the terminating newline, or end if there is none.
+ */
+inline const char* findLineEnd(const char *pos, const char *end)
+{
+    const char *newline = (const char*) memchr(pos, '\n', end - pos);
+    return (newline == NULL) ? end : newline;
+}
+
+bool parseInt(boost::string_ref text, int &value);
+bool parseUnsigned(boost::string_ref text, unsigned int &value);
+
+#endif // FIELDSCANNER_H
@@ -14,11 +14,14 @@
  */
 
 #include "languagepair.hpp"
+#include "casefold.hpp"
+#include "fieldscanner.hpp"
+
+#include <sstream>
 
 using namespace std;
 using namespace boost;
-using boost::lexical_cast;
-using boost::bad_lexical_cast;  // Used to catch bad lexical casts
+using boost::string_ref;
 
 /**
  * This default constructor should not be called and will throw an error, but
@@ -31,6 +34,7 @@ LanguagePair::LanguagePair()
 {
     lang1 = "";
     lang2 = "";
+    lang1Id = lang2Id = NO_LANGUAGE;
     valid = false;
 }
 
@@ -43,6 +47,8 @@ LanguagePair::LanguagePair(LanguagePair* existing)
 {
     lang1 = existing->lang1;
     lang2 = existing->lang2;
+    lang1Id = existing->lang1Id;
+    lang2Id = existing->lang2Id;
     homeLang = existing->homeLang;
     valid = existing->isValid();
 }
@@ -61,9 +67,10 @@ LanguagePair::LanguagePair(LanguagePair* existing)
  * @param myLang2 The other language in the pair
  * @param whichIsHome 1 if myLang1 is the home language, 2 if myLang2 is
  */
-LanguagePair::LanguagePair(string myLang1, string myLang2, int whichIsHome)
+LanguagePair::LanguagePair(const string &myLang1, const string &myLang2,
+                           int whichIsHome)
 {
-    if(boost::iequals(myLang1, myLang2))
+    if(caseInsensitiveEquals(myLang1, myLang2))
         throw new InvalidLanguageException;
 
     if(boost::algorithm::lexicographical_compare(myLang1, myLang2,
@@ -81,6 +88,7 @@ LanguagePair::LanguagePair(string myLang1, string myLang2, int whichIsHome)
         lang1 = myLang2;
         lang2 = myLang1;
     }
+    identifyLanguages();
     valid = true;
 }
 
@@ -94,42 +102,29 @@ LanguagePair::LanguagePair(string myLang1, string myLang2, int whichIsHome)
  *  the order of languages was reversed (ie they needed sorting).
  * @return True if the load was successful, false otherwise
  */
-bool LanguagePair::loadFromLine(string line, int *status)
+bool LanguagePair::loadFromLine(const string &line, int *status)
 {
-    string myLang1, myLang2;
+    FieldScanner fields(line);
+    string_ref myLang1, myLang2, field;
 
     *status = 0;
 
-    // Tokenize based on tab characters
-    char_separator <char> sep("\t");
-    tokenizer <char_separator <char> > tokens(line, sep);
-    tokenizer<char_separator <char> >::iterator itr = tokens.begin();
-
     // Make sure there are at least two tokens. A third may be used to
     // specify the home language.
-    myLang1 = *itr;
-    itr++;
-    if(itr == tokens.end())
+    if(!fields.next(myLang1) || !fields.next(myLang2))
         return false;
-    myLang2 = *itr;
 
     // Check to see if the languages are equal (this is not allowed)
-    if(boost::iequals(myLang1, myLang2))
+    if(caseInsensitiveEquals(myLang1, myLang2))
         return false;
 
-    itr++;
-
-    if(itr != tokens.end())
+    if(fields.next(field))
     {
         // Get the home language, or return a problem load
-        try
-        {
-            homeLang = lexical_cast<unsigned int>(*itr);
-        }
-        catch(bad_lexical_cast &)
-        {
+        unsigned int myHomeLang;
+        if(!parseUnsigned(field, myHomeLang))
             return false;
-        }
+        homeLang = myHomeLang;
     }
     else
     {
@@ -141,28 +136,40 @@ bool LanguagePair::loadFromLine(string line, int *status)
         (myLang1, myLang2, boost::is_iless()))
     {
         // Languages were specified in order
-        lang1 = myLang1;
-        lang2 = myLang2;
+        lang1 = myLang1.to_string();
+        lang2 = myLang2.to_string();
     }
     else
     {
         // Swap languages
-        lang1 = myLang2;
-        lang2 = myLang1;
+        lang1 = myLang2.to_string();
+        lang2 = myLang1.to_string();
         homeLang = (homeLang == 1) ? 2 : 1;
         *status = 1;
     }
 
+    identifyLanguages();
     valid = true;
     return true;
 }
 
 
+/**
+ * Looks up the IDs of the languages once, so that finding a pair's master
+ * list never touches the names.
+ */
+void LanguagePair::identifyLanguages()
+{
+    lang1Id = LanguageRegistry::instance().idOf(lang1);
+    lang2Id = LanguageRegistry::instance().idOf(lang2);
+}
+
+
 /**
  * Exports the information from a language pair into a one-line string
  * to be saved to a file.
  */
-string LanguagePair::exportToLine()
+string LanguagePair::exportToLine() const
 {
     if(!valid)
         throw new InvalidLanguageException;
@@ -207,7 +214,7 @@ string LanguagePair::exportToLine()
  * Returns an int specifying which language is the user's home language.
  * @return 1 if lang1 is home, 2 if lang2 is home.
  */
-short LanguagePair::whichLangIsHome()
+short LanguagePair::whichLangIsHome() const
 {
     if(!valid)
         throw new InvalidLanguageException;
@@ -241,7 +248,7 @@ void LanguagePair::setHomeLang(short newHomeLang)
  * language the user has set as their home language.
  * @return The name of the user's home language
  */
-std::string LanguagePair::getHomeLang()
+const std::string& LanguagePair::getHomeLang() const
 {
     if(!valid)
         throw new InvalidLanguageException;
@@ -257,7 +264,7 @@ std::string LanguagePair::getHomeLang()
  * language the user has set as their foreign language.
  * @return The name of the user's foreign language
  */
-std::string LanguagePair::getForeignLang()
+const std::string& LanguagePair::getForeignLang() const
 {
     if(!valid)
         throw new InvalidLanguageException;
@@ -272,7 +279,7 @@ std::string LanguagePair::getForeignLang()
 /**
  * A debugging tool to show the language pair's data.
  */
-void LanguagePair::printContents()
+void LanguagePair::printContents() const
 {
     cout << "LanguagePair: <" << lang1 << "," << lang2 << ">, home is: "
             << homeLang << endl;
@@ -280,7 +287,7 @@ void LanguagePair::printContents()
 }
 
 
-bool LanguagePair::isValid()
+bool LanguagePair::isValid() const
 {
     return valid;
 }
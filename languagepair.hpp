@@ -9,9 +9,8 @@
 
 #include <iostream>
 #include <boost/algorithm/string.hpp>
-#include <boost/lexical_cast.hpp>
-#include <boost/tokenizer.hpp>
 #include "exceptions.hpp"
+#include "languageregistry.hpp"
 
 class LanguagePair
 {
@@ -27,20 +26,36 @@ public:
     std::string lang1;
     std::string lang2;
 
+    //! The IDs of lang1 and lang2 in the LanguageRegistry, equal for two
+    //! pairs exactly when their languages are equal ignoring case.
+    unsigned int lang1Id;
+    unsigned int lang2Id;
+
     LanguagePair();
     LanguagePair(LanguagePair* existing);
-    LanguagePair(std::string myLang1, std::string myLang2, int whichIsHome);
+    LanguagePair(const std::string &myLang1, const std::string &myLang2,
+                 int whichIsHome);
 
-    bool loadFromLine(std::string line, int *status);
-    std::string exportToLine();
+    bool loadFromLine(const std::string &line, int *status);
+    std::string exportToLine() const;
 
-    short whichLangIsHome();
+    short whichLangIsHome() const;
     void setHomeLang(short newHomeLang);
-    std::string getHomeLang();
-    std::string getForeignLang();
+    const std::string& getHomeLang() const;
+    const std::string& getForeignLang() const;
+
+    void printContents() const;
+    bool isValid() const;
+
+    //! Whether two pairs have the same languages, ignoring case and the home
+    //! language.
+    bool sameLanguages(const LanguagePair &other) const
+    {
+        return lang1Id == other.lang1Id && lang2Id == other.lang2Id;
+    }
 
-    void printContents();
-    bool isValid();
+private:
+    void identifyLanguages();
 
 };
 
@@ -0,0 +1,87 @@
+/**
+ * @file languageregistry.cpp
+ * @brief Gives every language a small number.
+ * @author Alex Zirbel
+ *
+ * Languages are compared case insensitive all over the program, and every
+ * comparison of two names means folding their case. Instead, each language
+ * is given an ID the first time it is seen, shared by every capitalization
+ * of its name, so that two languages are the same exactly when their IDs
+ * are. IDs are handed out in order from 0, so they can index arrays.
+ *
+ * There are only ever a handful of languages, so IDs are never given back.
+ * Names which come from outside the program, such as a client's request,
+ * must be looked up with find rather than idOf, so that they cannot grow
+ * the registry without bound.
+ */
+
+#include "languageregistry.hpp"
+#include "casefold.hpp"
+
+using namespace std;
+using boost::string_ref;
+
+/**
+ * The registry shared by the whole program.
+ */
+LanguageRegistry& LanguageRegistry::instance()
+{
+    static LanguageRegistry registry;
+    return registry;
+}
+
+
+/**
+ * Returns the ID of a language, giving it the next free ID if it has not
+ * been seen before.
+ * @param language The name of the language, in any capitalization
+ */
+unsigned int LanguageRegistry::idOf(string_ref language)
+{
+    string folded = foldCase(language);
+
+    boost::mutex::scoped_lock lock(mutex);
+
+    boost::unordered_map<string, unsigned int>::iterator found;
+    found = ids.find(folded);
+    if(found != ids.end())
+        return found->second;
+
+    unsigned int id = ids.size();
+    ids.insert(make_pair(folded, id));
+    return id;
+}
+
+
+/**
+ * Looks up the ID of a language without registering it.
+ * @param language The name of the language, in any capitalization
+ * @param id Set to the language's ID if it has been seen
+ * @return False if the language has never been seen.
+ */
+bool LanguageRegistry::find(string_ref language, unsigned int &id)
+{
+    string folded = foldCase(language);
+
+    boost::mutex::scoped_lock lock(mutex);
+
+    boost::unordered_map<string, unsigned int>::iterator found;
+    found = ids.find(folded);
+    if(found == ids.end())
+        return false;
+
+    id = found->second;
+    return true;
+}
+
+
+/**
+ * Returns how many languages have been seen, which is one more than the
+ * largest ID handed out.
+ */
+size_t LanguageRegistry::size()
+{
+    boost::mutex::scoped_lock lock(mutex);
+
+    return ids.size();
+}
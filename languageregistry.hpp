@@ -0,0 +1,38 @@
+/**
+ * @file languageregistry.hpp
+ * @brief Header definitions for the LanguageRegistry class.
+ * @author Alex Zirbel
+ */
+
+#ifndef LANGUAGEREGISTRY_H
+#define LANGUAGEREGISTRY_H
+
+#include <string>
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/utility/string_ref.hpp>
+
+//! The ID of no language at all, held by blank language pairs.
+#define NO_LANGUAGE ((unsigned int) -1)
+
+class LanguageRegistry : boost::noncopyable
+{
+//! The ID of every language seen so far, keyed on the case-folded name.
+boost::unordered_map<std::string, unsigned int> ids;
+
+//! Language pairs are made on the loader and journal threads too.
+boost::mutex mutex;
+
+public:
+    static LanguageRegistry& instance();
+
+    unsigned int idOf(boost::string_ref language);
+    bool find(boost::string_ref language, unsigned int &id);
+    size_t size();
+
+private:
+    LanguageRegistry() { }
+};
+
+#endif // LANGUAGEREGISTRY_H
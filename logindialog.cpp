@@ -9,13 +9,47 @@
  */
 
 #include <QtGui>
+#include <QtConcurrentRun>
 #include "logindialog.hpp"
 
 using namespace std;
 
+/**
+ * Loads a profile on a worker thread. An exception which leaves the worker
+ * would be thrown again in the GUI thread, so a failed load is returned as a
+ * NULL profile and a message instead.
+ */
+static ProfileLoadResult loadProfileInBackground(ProfileManager *manager,
+                                                 string username)
+{
+    ProfileLoadResult result;
+    result.profile = NULL;
+
+    try
+    {
+        result.profile = manager->loadProfile(username);
+    }
+    catch(exception *e)
+    {
+        result.error = e->what();
+        delete e;
+    }
+    catch(exception &e)
+    {
+        result.error = e.what();
+    }
+    catch(...)
+    {
+        result.error = "The profile could not be loaded.";
+    }
+
+    return result;
+}
+
 LoginDialog::LoginDialog(QWidget *parent) : QDialog(parent)
 {
     profileManager = new ProfileManager;
+    loadWatcher = new QFutureWatcher<ProfileLoadResult>(this);
 
     loginPrompt = new QLabel(tr("Login as:"));
     loginPrompt->setObjectName("h1");
@@ -35,6 +69,8 @@ LoginDialog::LoginDialog(QWidget *parent) : QDialog(parent)
             this, SLOT(newProfileClicked()));
     connect(usernameLineEdit, SIGNAL(returnPressed()),
             this, SLOT(loginClicked()));
+    connect(loadWatcher, SIGNAL(finished()),
+            this, SLOT(loadFinished()));
 
     QHBoxLayout *loginHBox = new QHBoxLayout;
     loginHBox->addWidget(usernameLineEdit);
@@ -59,6 +95,8 @@ LoginDialog::LoginDialog(QWidget *parent) : QDialog(parent)
 
 LoginDialog::~LoginDialog()
 {
+    // The worker still uses profileManager until the load finishes
+    loadWatcher->waitForFinished();
 }
 
 
@@ -89,9 +127,49 @@ void LoginDialog::loginClicked()
         return;
     }
 
-    UserProfile *profile = profileManager->loadProfile(username);
+    // A large profile takes a while to load, so load it on a worker thread
+    // and keep the dialog responsive; loadFinished picks up the profile.
+    setBusy(true);
+    emit(loadingStarted(tr("Loading profile %1...")
+                        .arg(QString(username.c_str()))));
+
+    loadWatcher->setFuture(QtConcurrent::run(loadProfileInBackground,
+                                             profileManager, username));
+}
 
-    emit(submitProfile(profile));
+
+/**
+ * Hands over the profile once it has been loaded on the worker thread, or
+ * explains why it could not be loaded.
+ */
+void LoginDialog::loadFinished()
+{
+    ProfileLoadResult result = loadWatcher->result();
+
+    setBusy(false);
+    emit(loadingFinished());
+
+    if(result.profile == NULL)
+    {
+        QMessageBox::warning(this, tr("Login Page | WordQuiz"),
+                             tr("Unable to load the profile: %1")
+                             .arg(QString(result.error.c_str())));
+        return;
+    }
+
+    emit(submitProfile(result.profile));
+}
+
+
+/**
+ * Disables logging in while a profile is being loaded.
+ * @param busy True while a profile is loading, false once it has loaded
+ */
+void LoginDialog::setBusy(bool busy)
+{
+    usernameLineEdit->setEnabled(!busy);
+    loginButton->setEnabled(!busy);
+    newProfileButton->setEnabled(!busy);
 }
 
 
@@ -8,6 +8,7 @@
 #define LOGINDIALOG_H
 
 #include <QDialog>
+#include <QFutureWatcher>
 #include <boost/lexical_cast.hpp>
 
 #include "profilemanager.hpp"
@@ -17,6 +18,15 @@ class QLabel;
 class QLineEdit;
 class QPushButton;
 
+/**
+ * The outcome of loading a profile on a worker thread.
+ */
+struct ProfileLoadResult
+{
+    UserProfile *profile;   //!< The loaded profile, or NULL if it failed
+    std::string error;      //!< Why the load failed, if it did
+};
+
 class LoginDialog : public QDialog
 {
     Q_OBJECT
@@ -27,6 +37,8 @@ QLabel *loginPrompt;
 QLineEdit *usernameLineEdit;
 QPushButton *loginButton;
 QPushButton *newProfileButton;
+//! Watches the profile being loaded on a worker thread, if any.
+QFutureWatcher<ProfileLoadResult> *loadWatcher;
 
 public:
     LoginDialog(QWidget *parent = 0);
@@ -35,10 +47,16 @@ public:
 signals:
     void submitProfile(UserProfile *profile);
     void requestNewProfile();
+    void loadingStarted(const QString &message);
+    void loadingFinished();
 
 private slots:
     void loginClicked();
     void newProfileClicked();
+    void loadFinished();
+
+private:
+    void setBusy(bool busy);
 };
 
 #endif // LOGINDIALOG_H
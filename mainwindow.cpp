@@ -19,9 +19,18 @@ using namespace std;
  */
 MainWindow::MainWindow()
 {
+    journal = NULL;
+
     createActions();
     createMenus();
 
+    // The range 0 to 0 makes the bar show activity without a percentage
+    loadingBar = new QProgressBar;
+    loadingBar->setRange(0, 0);
+    loadingBar->setMaximumWidth(150);
+    loadingBar->hide();
+    statusBar()->addPermanentWidget(loadingBar);
+
     setCurrentFile("");
 
     setWindowTitle(tr("WordQuiz"));
@@ -69,6 +78,28 @@ void MainWindow::updateStatusBar()
 }
 
 
+/**
+ * Shows that a profile is loading or saving in the background. The window
+ * stays usable while it does.
+ * @param message What is being done, shown in the status bar
+ */
+void MainWindow::showLoading(const QString &message)
+{
+    statusBar()->showMessage(message);
+    loadingBar->show();
+}
+
+
+/**
+ * Clears the status bar once a background load or save has finished.
+ */
+void MainWindow::hideLoading()
+{
+    statusBar()->clearMessage();
+    loadingBar->hide();
+}
+
+
 void MainWindow::createActions()
 {
     openAction = new QAction(tr("&Open..."), this);
@@ -181,6 +212,10 @@ void MainWindow::switchToLoginDialog()
     //! @todo switch to newprofile
     connect(loginDialog, SIGNAL(requestNewProfile()), this,
             SLOT(switchToNewProfileDialog()));
+    connect(loginDialog, SIGNAL(loadingStarted(const QString&)), this,
+            SLOT(showLoading(const QString&)));
+    connect(loginDialog, SIGNAL(loadingFinished()), this,
+            SLOT(hideLoading()));
 }
 
 
@@ -191,6 +226,10 @@ void MainWindow::switchToNewProfileDialog()
             SLOT(handleLogin(UserProfile*)));*/
     connect(newProfileDialog, SIGNAL(back()), this,
             SLOT(switchToLoginDialog()));
+    connect(newProfileDialog, SIGNAL(loadingStarted(const QString&)), this,
+            SLOT(showLoading(const QString&)));
+    connect(newProfileDialog, SIGNAL(loadingFinished()), this,
+            SLOT(hideLoading()));
 
     setCentralWidget(newProfileDialog);
 }
@@ -224,9 +263,15 @@ void MainWindow::switchToMenuDialog()
  */
 void MainWindow::handleLogin(UserProfile *profile)
 {
+    // Finish with the previous user's journal before replacing the profile
+    ProfileManager profileManager;
+    profileManager.closeJournal(journal, &currentUser);
+
     // Process this login
     currentUser = *profile;
 
+    journal = profileManager.openJournal(&currentUser);
+
     switchToLanguageDialog();
 }
 
@@ -249,6 +294,7 @@ void MainWindow::startQuiz()
 {
     QuizList *temp = new MasterList;
     quizDialog = new QuizDialog(temp);
+    quizDialog->setJournal(journal);
 
     setCentralWidget(quizDialog);
 }
@@ -18,11 +18,14 @@
 
 #include "languagepair.hpp"
 #include "userprofile.hpp"
+#include "profilemanager.hpp"
+#include "answerjournal.hpp"
 
 #include "util_global.hpp"
 
 class QAction;
 class QLabel;
+class QProgressBar;
 //! @todo remove - I don't think these are necessary
 class LoginDialog;
 class LanguageDialog;
@@ -41,6 +44,8 @@ QuizDialog *quizDialog;
 
 //! Global variables for the session. Is there a way around them?
 UserProfile currentUser;
+//! Records the answers of currentUser as they are given.
+AnswerJournal *journal;
 
 //! Stores the current pair of languages the user is studying, including
 //! which one the user has set as their home language.
@@ -50,6 +55,8 @@ MasterList *nextToQuiz;
 
 QLabel *locationLabel;
 QLabel *formulaLabel;
+//! A busy indicator shown in the status bar while a profile loads or saves.
+QProgressBar *loadingBar;
 QStringList recentFiles;
 QString curFile;
 
@@ -76,6 +83,8 @@ private slots:
     void about();
     void openRecentFile();
     void updateStatusBar();
+    void showLoading(const QString &message);
+    void hideLoading();
 
     void switchToLoginDialog();
     void switchToNewProfileDialog();
@@ -10,13 +10,48 @@
  */
 
 #include <QtGui>
+#include <QtConcurrentRun>
 #include "newprofiledialog.hpp"
 
 using namespace std;
 
+/**
+ * Saves a new profile on a worker thread. An exception which leaves the
+ * worker would be thrown again in the GUI thread, so a failed save is
+ * returned as a message instead.
+ * @return Why the profile could not be saved, or "" if it was saved
+ */
+static string saveProfileInBackground(ProfileManager *manager,
+                                      UserProfile *profile)
+{
+    try
+    {
+        if(!manager->saveProfile(profile))
+            return "The profile file could not be written.";
+    }
+    catch(exception *e)
+    {
+        string error = e->what();
+        delete e;
+        return error;
+    }
+    catch(exception &e)
+    {
+        return e.what();
+    }
+    catch(...)
+    {
+        return "The profile could not be saved.";
+    }
+
+    return "";
+}
+
 NewProfileDialog::NewProfileDialog(QWidget *parent) : QDialog(parent)
 {
     profileManager = new ProfileManager;
+    savingProfile = NULL;
+    saveWatcher = new QFutureWatcher<string>(this);
 
     usernamePrompt = new QLabel(tr("Pick a username for yourself!"));
     usernamePrompt->setObjectName("h1");
@@ -42,6 +77,8 @@ NewProfileDialog::NewProfileDialog(QWidget *parent) : QDialog(parent)
         this, SLOT(createClicked()));
     connect(backButton, SIGNAL(clicked()),
         this, SLOT(backClicked()));
+    connect(saveWatcher, SIGNAL(finished()),
+        this, SLOT(saveFinished()));
 
     QHBoxLayout *buttonBox = new QHBoxLayout;
     buttonBox->addWidget(createButton);
@@ -71,6 +108,8 @@ NewProfileDialog::NewProfileDialog(QWidget *parent) : QDialog(parent)
 
 NewProfileDialog::~NewProfileDialog()
 {
+    // The worker still uses profileManager until the save finishes
+    saveWatcher->waitForFinished();
 }
 
 
@@ -96,16 +135,58 @@ void NewProfileDialog::createClicked()
         return;
     }
 
-    UserProfile *profile = profileManager->createNewProfile(username, fullName);
-    if(!profileManager->saveProfile(profile))
+    // Save on a worker thread so the dialog stays responsive; saveFinished
+    // hands the profile on once it is written.
+    savingProfile = profileManager->createNewProfile(username, fullName);
+    setBusy(true);
+    emit(loadingStarted(tr("Saving profile %1...")
+                        .arg(QString(username.c_str()))));
+
+    saveWatcher->setFuture(QtConcurrent::run(saveProfileInBackground,
+                                             profileManager, savingProfile));
+}
+
+
+/**
+ * Hands over the new profile once it has been saved on the worker thread.
+ * If it could not be saved, explains why and lets the user try again.
+ */
+void NewProfileDialog::saveFinished()
+{
+    string error = saveWatcher->result();
+
+    UserProfile *profile = savingProfile;
+    savingProfile = NULL;
+
+    setBusy(false);
+    emit(loadingFinished());
+
+    if(!error.empty())
     {
-        cout << "Problem saving profile." << endl;
+        delete profile;
+        QMessageBox::warning(this, tr("Create New Profile | WordQuiz"),
+                             tr("Unable to save the profile: %1")
+                             .arg(QString(error.c_str())));
+        return;
     }
 
     emit(submitProfile(profile));
 }
 
 
+/**
+ * Disables creating a profile or leaving the page while one is being saved.
+ * @param busy True while a profile is saving, false once it has been saved
+ */
+void NewProfileDialog::setBusy(bool busy)
+{
+    usernameLineEdit->setEnabled(!busy);
+    fullNameLineEdit->setEnabled(!busy);
+    createButton->setEnabled(!busy);
+    backButton->setEnabled(!busy);
+}
+
+
 void NewProfileDialog::backClicked()
 {
     emit(back());
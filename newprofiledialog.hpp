@@ -8,6 +8,7 @@
 #define NEWPROFILEDIALOG_H
 
 #include <QDialog>
+#include <QFutureWatcher>
 #include <boost/lexical_cast.hpp>
 
 #include "profilemanager.hpp"
@@ -32,6 +33,10 @@ QLabel *fullNamePromptSub;
 QLineEdit *fullNameLineEdit;
 QPushButton *createButton;
 QPushButton *backButton;
+//! The profile being saved on a worker thread, if any.
+UserProfile *savingProfile;
+//! Watches the save of savingProfile, which reports why it failed, if it did.
+QFutureWatcher<std::string> *saveWatcher;
 
 public:
     NewProfileDialog(QWidget *parent = 0);
@@ -40,10 +45,16 @@ public:
 signals:
     void submitProfile(UserProfile *profile);
     void back();
+    void loadingStarted(const QString &message);
+    void loadingFinished();
 
 private slots:
     void createClicked();
     void backClicked();
+    void saveFinished();
+
+private:
+    void setBusy(bool busy);
 };
 
 #endif // NEWPROFILEDIALOG_H
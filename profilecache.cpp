@@ -0,0 +1,264 @@
+/**
+ * @file profilecache.cpp
+ * @brief Keeps recently loaded profiles in memory.
+ * @author Alex Zirbel
+ *
+ * Loading a profile means parsing its file and replaying its journal, which
+ * is slow for large profiles. On a shared machine the same few users log in
+ * over and over, so the profiles loaded most recently are kept, up to a
+ * memory budget, and the least recently used are dropped first.
+ *
+ * A cached profile is only used while its profile files and journal are
+ * exactly as they were when it was loaded, judged by their modification
+ * times to the nanosecond, sizes and inodes. Any answer recorded or profile
+ * saved since changes them, so a stale profile is never handed out. A
+ * session which saves its profile or closes its journal caches the profile
+ * again along with the new state of the files, since the profile it has in
+ * memory is exactly what the next login would load.
+ *
+ * The memory budget counts everything a cached profile keeps alive when it
+ * is cached. Its word pool is shared with the copies handed out, which may
+ * add words to it on other threads as they load lists, so it is measured
+ * only once, by the thread caching the profile; words added later are not
+ * counted until the profile is cached again.
+ *
+ * Callers always get their own copy of a cached profile, which they own and
+ * may change freely. The copy shares the cached profile's word pool, which
+ * words are only ever added to.
+ */
+
+#include "profilecache.hpp"
+
+#include <sys/stat.h>
+
+using namespace std;
+
+FileStamp::FileStamp()
+{
+    exists = false;
+    modified = 0;
+    modifiedNanoseconds = 0;
+    size = 0;
+    inode = 0;
+}
+
+/**
+ * Reads the current state of a file.
+ */
+FileStamp FileStamp::ofFile(const string &filename)
+{
+    FileStamp stamp;
+    struct stat info;
+
+    if(stat(filename.c_str(), &info) == 0)
+    {
+        stamp.exists = true;
+        stamp.modified = info.st_mtim.tv_sec;
+        stamp.modifiedNanoseconds = info.st_mtim.tv_nsec;
+        stamp.size = info.st_size;
+        stamp.inode = info.st_ino;
+    }
+
+    return stamp;
+}
+
+bool FileStamp::operator==(const FileStamp &other) const
+{
+    return exists == other.exists && modified == other.modified &&
+           modifiedNanoseconds == other.modifiedNanoseconds &&
+           size == other.size && inode == other.inode;
+}
+
+bool ProfileStamp::operator==(const ProfileStamp &other) const
+{
+    return binary == other.binary && text == other.text &&
+           journal == other.journal;
+}
+
+ProfileCacheStatistics::ProfileCacheStatistics()
+{
+    hits = 0;
+    misses = 0;
+    invalidations = 0;
+    evictions = 0;
+    profiles = 0;
+    bytesUsed = 0;
+    maxBytes = 0;
+}
+
+
+ProfileCache::ProfileCache(size_t maxBytes)
+{
+    statistics.maxBytes = maxBytes;
+}
+
+
+/**
+ * Looks for a profile in the cache.
+ * @param username The user whose profile is wanted
+ * @param stamp The current state of the profile's files
+ * @return A copy of the cached profile, owned by the caller, or NULL if the
+ *  profile is not cached or its files have changed since it was.
+ */
+UserProfile* ProfileCache::find(const string &username,
+                                const ProfileStamp &stamp)
+{
+    boost::mutex::scoped_lock lock(mutex);
+
+    boost::unordered_map<string, list<Entry>::iterator>::iterator found;
+    found = index.find(username);
+
+    if(found == index.end())
+    {
+        statistics.misses++;
+        return NULL;
+    }
+
+    list<Entry>::iterator entry = found->second;
+    if(!(entry->stamp == stamp))
+    {
+        statistics.misses++;
+        statistics.invalidations++;
+        erase(entry);
+        return NULL;
+    }
+
+    // Move to the front, as the most recently used
+    entries.splice(entries.begin(), entries, entry);
+    statistics.hits++;
+
+    return new UserProfile(*entry->profile);
+}
+
+
+/**
+ * Caches a copy of a profile, replacing any older copy, and drops the least
+ * recently used profiles until the cache is within its budget again. A
+ * profile larger than the whole budget is not cached.
+ * @param username The user the profile belongs to
+ * @param stamp The state of the profile's files the profile matches
+ * @param profile The loaded or just saved profile
+ */
+void ProfileCache::insert(const string &username, const ProfileStamp &stamp,
+                          const UserProfile &profile)
+{
+    boost::shared_ptr<UserProfile> copy(new UserProfile(profile));
+
+    // The word pool is shared with the profile being cached and with the
+    // copies find hands out, which may add to it on other threads; it is
+    // only safe to measure here, on the thread the profile belongs to
+    size_t bytes = copy->bytesUsed();
+
+    boost::mutex::scoped_lock lock(mutex);
+
+    boost::unordered_map<string, list<Entry>::iterator>::iterator found;
+    found = index.find(username);
+    if(found != index.end())
+        erase(found->second);
+
+    if(bytes > statistics.maxBytes)
+        return;
+
+    Entry entry;
+    entry.username = username;
+    entry.stamp = stamp;
+    entry.profile = copy;
+    entry.bytes = bytes;
+
+    entries.push_front(entry);
+    index[username] = entries.begin();
+    statistics.profiles++;
+
+    evictToFit();
+}
+
+
+/**
+ * Drops a user's profile from the cache, if it is there.
+ */
+void ProfileCache::invalidate(const string &username)
+{
+    boost::mutex::scoped_lock lock(mutex);
+
+    boost::unordered_map<string, list<Entry>::iterator>::iterator found;
+    found = index.find(username);
+    if(found != index.end())
+        erase(found->second);
+}
+
+
+/**
+ * Drops every profile from the cache. The statistics are kept.
+ */
+void ProfileCache::clear()
+{
+    boost::mutex::scoped_lock lock(mutex);
+
+    entries.clear();
+    index.clear();
+    statistics.profiles = 0;
+}
+
+
+/**
+ * Sets the memory budget of the cache, dropping profiles if it is now over.
+ * @param maxBytes The most memory cached profiles may take, 0 to cache none
+ */
+void ProfileCache::setMaxBytes(size_t maxBytes)
+{
+    boost::mutex::scoped_lock lock(mutex);
+
+    statistics.maxBytes = maxBytes;
+    evictToFit();
+}
+
+
+ProfileCacheStatistics ProfileCache::getStatistics()
+{
+    boost::mutex::scoped_lock lock(mutex);
+
+    statistics.bytesUsed = measure();
+    return statistics;
+}
+
+
+/**
+ * Removes an entry; the mutex must be held.
+ */
+void ProfileCache::erase(list<Entry>::iterator entry)
+{
+    statistics.profiles--;
+
+    index.erase(entry->username);
+    entries.erase(entry);
+}
+
+
+/**
+ * Drops the least recently used profiles until the cache is within its
+ * budget; the mutex must be held.
+ */
+void ProfileCache::evictToFit()
+{
+    while(!entries.empty() && measure() > statistics.maxBytes)
+    {
+        erase(--entries.end());
+        statistics.evictions++;
+    }
+}
+
+
+/**
+ * Adds up the memory the cached profiles took when they were cached; the
+ * mutex must be held.
+ */
+size_t ProfileCache::measure()
+{
+    size_t bytes = 0;
+
+    list<Entry>::iterator itr;
+    for(itr = entries.begin(); itr != entries.end(); itr++)
+        bytes += itr->bytes;
+
+    return bytes;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file profilecache.hpp
+ * @brief Header definitions for the ProfileCache class.
+ * @author Alex Zirbel
+ */
+
+#ifndef PROFILECACHE_H
+#define PROFILECACHE_H
+
+#include <ctime>
+#include <list>
+#include <string>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "userprofile.hpp"
+
+//! The memory profiles may take up in the cache by default.
+#define DEFAULT_PROFILE_CACHE_BYTES (256 * 1024 * 1024)
+
+/**
+ * The state of one file on disk, to tell whether it has changed.
+ */
+struct FileStamp
+{
+    bool exists;
+    time_t modified;
+    //! The fraction of a second of modified, so that two changes within the
+    //! same second can be told apart
+    long modifiedNanoseconds;
+    boost::uint64_t size;
+    //! Changes when the file is replaced by a new one, as saves do
+    boost::uint64_t inode;
+
+    FileStamp();
+    static FileStamp ofFile(const std::string &filename);
+    bool operator==(const FileStamp &other) const;
+};
+
+/**
+ * The state of every file a profile is loaded from. A cached profile is
+ * only used while all of them are unchanged.
+ */
+struct ProfileStamp
+{
+    FileStamp binary;
+    FileStamp text;
+    FileStamp journal;
+
+    bool operator==(const ProfileStamp &other) const;
+};
+
+/**
+ * How well the cache has been doing.
+ */
+struct ProfileCacheStatistics
+{
+    unsigned long hits;
+    unsigned long misses;
+    //! Misses because the profile's files had changed
+    unsigned long invalidations;
+    //! Profiles dropped to stay within the memory budget
+    unsigned long evictions;
+    size_t profiles;
+    size_t bytesUsed;
+    size_t maxBytes;
+
+    ProfileCacheStatistics();
+};
+
+class ProfileCache : boost::noncopyable
+{
+/**
+ * A loaded profile, with the state of its files when it was loaded.
+ */
+struct Entry
+{
+    std::string username;
+    ProfileStamp stamp;
+    boost::shared_ptr<UserProfile> profile;
+    //! The memory the profile took when it was cached
+    size_t bytes;
+};
+
+//! The cached profiles, most recently used first.
+std::list<Entry> entries;
+//! Where each username's profile is in entries.
+boost::unordered_map<std::string, std::list<Entry>::iterator> index;
+
+ProfileCacheStatistics statistics;
+
+//! Profiles are loaded and saved on worker threads.
+boost::mutex mutex;
+
+public:
+    ProfileCache(size_t maxBytes = DEFAULT_PROFILE_CACHE_BYTES);
+
+    UserProfile* find(const std::string &username, const ProfileStamp &stamp);
+    void insert(const std::string &username, const ProfileStamp &stamp,
+                const UserProfile &profile);
+    void invalidate(const std::string &username);
+    void clear();
+
+    void setMaxBytes(size_t maxBytes);
+    ProfileCacheStatistics getStatistics();
+
+private:
+    void erase(std::list<Entry>::iterator entry);
+    void evictToFit();
+    size_t measure();
+};
+
+#endif // PROFILECACHE_H
@@ -53,7 +53,16 @@ UserProfile* ProfileManager::createNewProfile(string username, string fullName)
 
 /**
  * Loads a user profile from a file.
- * Assumes the "username" profile exists; throws an exception if not.
+ * Assumes the "username" profile exists; throws an exception if not, and
+ * throws an InvalidUserProfileException if its file cannot be read.
+ *
+ * The binary profile is preferred since it loads much faster. A profile which
+ * only exists in the text format is imported from the text file; it will be
+ * saved in the binary format the next time it is saved. Answers recorded in
+ * the profile's journal since it was last saved are then replayed.
+ *
+ * Profiles loaded recently are kept in memory, and copied from there rather
+ * than loaded again while their files are unchanged.
  */
 UserProfile* ProfileManager::loadProfile(string username)
 {
@@ -66,17 +75,42 @@ UserProfile* ProfileManager::loadProfile(string username)
         throw exception;
     }
 
-    string filename = usernameToFilename(username);
+    // Stamp the files before reading them, so that a change made during the
+    // load makes the cached copy stale rather than hiding the change
+    ProfileStamp stamp = profileStamp(username);
+
+    UserProfile *cached = cache().find(username, stamp);
+    if(cached != NULL)
+        return cached;
+
+    string binaryFilename = usernameToBinaryFilename(username);
 
     UserProfile *toReturn = new UserProfile;
-    toReturn->loadProfile(filename);
+    bool loaded;
+
+    if(fexists(binaryFilename))
+        loaded = toReturn->loadBinaryProfile(binaryFilename);
+    else
+        loaded = toReturn->loadProfile(usernameToFilename(username));
+
+    // A broken profile must never be replayed into, cached or handed out
+    if(!loaded || !toReturn->isValid())
+    {
+        delete toReturn;
+        throw new InvalidUserProfileException;
+    }
+
+    AnswerJournal::replay(usernameToJournalFilename(username), toReturn);
+
+    cache().insert(username, stamp, *toReturn);
 
     return toReturn;
 }
 
 
 /**
- * Saves a profile according to the profile's informaion.
+ * Saves a profile according to the profile's informaion, in the binary
+ * format. The text format is only written on explicit export.
  */
 bool ProfileManager::saveProfile(UserProfile *profile)
 {
@@ -85,11 +119,68 @@ bool ProfileManager::saveProfile(UserProfile *profile)
         return false;
     }
 
-    profile->saveProfile(usernameToFilename(profile->getUsername()));
+    string username = profile->getUsername();
+    if(!profile->saveBinaryProfile(usernameToBinaryFilename(username)))
+    {
+        cache().invalidate(username);
+        return false;
+    }
+
+    // What was just saved is what the next login would load
+    cache().insert(username, profileStamp(username), *profile);
     return true;
 }
 
 
+/**
+ * Opens the answer journal of a loaded profile, so that quiz answers can be
+ * saved without rewriting the whole profile. The journal is compacted into
+ * the profile's binary file in the background as it grows.
+ * @param profile The profile to record answers for; must outlive the journal
+ * @return The journal, or NULL if it could not be opened. The caller owns it.
+ */
+AnswerJournal* ProfileManager::openJournal(UserProfile *profile)
+{
+    if(!isValidUsername(profile->getUsername()) || !profile->isValid())
+        return NULL;
+
+    string username = profile->getUsername();
+    AnswerJournal *journal =
+            new AnswerJournal(profile, usernameToBinaryFilename(username));
+
+    if(!journal->open(usernameToJournalFilename(username)))
+    {
+        delete journal;
+        return NULL;
+    }
+
+    return journal;
+}
+
+
+/**
+ * Closes the journal of a profile the user has finished with, waiting for
+ * any compaction to finish. Every answer in the journal was also made to the
+ * profile in memory, so the profile is cached along with the new state of
+ * its files: logging in again finds it there instead of loading it again.
+ * @param journal The journal from openJournal, which is deleted; may be NULL
+ * @param profile The profile the journal recorded answers for
+ */
+void ProfileManager::closeJournal(AnswerJournal *journal, UserProfile *profile)
+{
+    if(journal == NULL)
+        return;
+
+    delete journal;
+
+    if(!isValidUsername(profile->getUsername()) || !profile->isValid())
+        return;
+
+    string username = profile->getUsername();
+    cache().insert(username, profileStamp(username), *profile);
+}
+
+
 /**
  * Checks through the list of saved profiles (or rather, though actual
  * filenames in the profiles/ folder) to see if a user has created a profile
@@ -101,9 +192,54 @@ bool ProfileManager::profileExists(string username)
     if(!isValidUsername(username))
         throw new InvalidUsernameException;
 
-    string filename = usernameToFilename(username);
+    return fexists(usernameToBinaryFilename(username)) ||
+           fexists(usernameToFilename(username));
+}
+
 
-    return fexists(filename);
+/**
+ * Returns how well the profile cache, shared by every ProfileManager, has
+ * been doing.
+ */
+ProfileCacheStatistics ProfileManager::getCacheStatistics()
+{
+    return cache().getStatistics();
+}
+
+
+/**
+ * Sets how much memory the profile cache may use.
+ * @param maxBytes The budget in bytes, or 0 to always load from disk
+ */
+void ProfileManager::setCacheBudget(size_t maxBytes)
+{
+    cache().setMaxBytes(maxBytes);
+}
+
+
+/**
+ * The cache of loaded profiles, shared by every ProfileManager since each
+ * dialog has its own manager.
+ */
+ProfileCache& ProfileManager::cache()
+{
+    static ProfileCache profiles;
+    return profiles;
+}
+
+
+/**
+ * Reads the state of every file a user's profile is loaded from.
+ */
+ProfileStamp ProfileManager::profileStamp(string username)
+{
+    ProfileStamp stamp;
+
+    stamp.binary = FileStamp::ofFile(usernameToBinaryFilename(username));
+    stamp.text = FileStamp::ofFile(usernameToFilename(username));
+    stamp.journal = FileStamp::ofFile(usernameToJournalFilename(username));
+
+    return stamp;
 }
 
 
@@ -130,6 +266,36 @@ string ProfileManager::usernameToFilename(string username)
 }
 
 
+/**
+ * Takes a username and converts it to the full path of the user's binary
+ * profile, which sits next to the text profile.
+ */
+string ProfileManager::usernameToBinaryFilename(string username)
+{
+    string filename = usernameToFilename(username);
+
+    // Swap the .txt extension for .wqp
+    filename.replace(filename.size() - 4, 4, ".wqp");
+
+    return filename;
+}
+
+
+/**
+ * Takes a username and converts it to the full path of the user's answer
+ * journal, which sits next to the profile.
+ */
+string ProfileManager::usernameToJournalFilename(string username)
+{
+    string filename = usernameToFilename(username);
+
+    // Swap the .txt extension for .wqj
+    filename.replace(filename.size() - 4, 4, ".wqj");
+
+    return filename;
+}
+
+
 /**
  * Ensures that usernames contain only normal characters which would
  * not corrupt filenames.
@@ -9,6 +9,8 @@
 
 #include <iostream>
 #include "userprofile.hpp"
+#include "answerjournal.hpp"
+#include "profilecache.hpp"
 #include "exceptions.hpp"
 #include "util_global.hpp"
 
@@ -24,13 +26,22 @@ public:
     UserProfile* createNewProfile(std::string username, std::string fullName);
     UserProfile* loadProfile(std::string username);
     bool saveProfile(UserProfile *profile);
+    AnswerJournal* openJournal(UserProfile *profile);
+    void closeJournal(AnswerJournal *journal, UserProfile *profile);
     bool isValidUsername(std::string username);
     bool profileExists(std::string username);
 
+    ProfileCacheStatistics getCacheStatistics();
+    void setCacheBudget(size_t maxBytes);
+
 private:
+    static ProfileCache& cache();
+    ProfileStamp profileStamp(std::string username);
     bool fexists(std::string filename);
     bool legalCharacter(char c);
     std::string usernameToFilename(std::string username);
+    std::string usernameToBinaryFilename(std::string username);
+    std::string usernameToJournalFilename(std::string username);
 
 };
 
@@ -0,0 +1,238 @@
+/**
+ * @file profilesnapshot.cpp
+ * @brief A frozen copy of a user profile, for saving in the background.
+ * @author Alex Zirbel
+ *
+ * Saving a profile takes far longer than answering a question, so it should
+ * not hold up the quiz. A snapshot records what the profile held at one
+ * moment: the user's names and the connection table of each master list.
+ * Tables share their rows with the live profile until the profile changes
+ * them (see ConnectionTable), so taking a snapshot copies nothing but a
+ * pointer per list, and the snapshot never changes afterwards. It can be
+ * written out on another thread while the quiz goes on.
+ *
+ * Lists which were never loaded from the binary profile file are not loaded
+ * for the snapshot either. The snapshot keeps the file mapped and copies
+ * such a list byte for byte into the new binary file, so saving does no
+ * parsing for it. They cannot be written in the text format.
+ *
+ * Both file formats are written here; they are described in
+ * userprofile.cpp, which reads them.
+ */
+
+#include "profilesnapshot.hpp"
+#include "bufferedwriter.hpp"
+#include "userprofile.hpp"
+
+#include <boost/cstdint.hpp>
+
+using namespace std;
+using namespace boost;
+
+/**
+ * Starts a snapshot with no master lists.
+ * @param pool The word pool every list added to the snapshot uses
+ */
+ProfileSnapshot::ProfileSnapshot(string myUsername, string myFullName,
+                                 boost::shared_ptr<WordPool> pool)
+{
+    username = myUsername;
+    fullName = myFullName;
+    wordPool = pool;
+}
+
+
+/**
+ * Adds a master list to the snapshot. Its rows are shared, not copied.
+ */
+void ProfileSnapshot::addSection(const LanguagePair &languages,
+                                 const ConnectionTable &connections)
+{
+    SnapshotSection section;
+    section.languages = languages;
+    section.connections = connections;
+    section.rawData = NULL;
+    section.rawSize = 0;
+
+    sections.push_back(section);
+}
+
+
+/**
+ * Adds a master list which is still in the binary profile file, to be
+ * copied as it is.
+ * @param file The mapped profile file, kept until the snapshot is deleted
+ * @param data Where the list's section starts in the file
+ * @param size The length of the section
+ */
+void ProfileSnapshot::addRawSection(
+        const LanguagePair &languages,
+        boost::shared_ptr<interprocess::mapped_region> file,
+        const char *data, size_t size)
+{
+    SnapshotSection section;
+    section.languages = languages;
+    section.rawFile = file;
+    section.rawData = data;
+    section.rawSize = size;
+
+    sections.push_back(section);
+}
+
+
+/**
+ * Saves the snapshot in the text profile format. The file is replaced in one
+ * step once it has been written in full.
+ * @param filename The full path and name of the file
+ * @return True if the save was successful, false otherwise, including if the
+ *  snapshot holds lists copied from the binary file.
+ */
+bool ProfileSnapshot::saveProfile(string filename) const
+{
+    for(size_t i = 0; i < sections.size(); i++)
+    {
+        if(sections[i].rawData != NULL)
+            return false;
+    }
+
+    BufferedWriter userFile;
+
+    // Check for failed file open
+    if(!userFile.open(filename))
+        return false;
+
+    userFile.write(username);
+    userFile.put('\n');
+    userFile.write(fullName);
+    userFile.put('\n');
+
+    for(size_t i = 0; i < sections.size(); i++)
+    {
+        userFile.write("---\n");
+
+        const LanguagePair &lp = sections[i].languages;
+
+        userFile.write(lp.lang1);
+        userFile.put('\t');
+        userFile.write(lp.lang2);
+        userFile.put('\t');
+        userFile.writeInt(lp.homeLang);
+        userFile.put('\n');
+
+        sections[i].connections.writeRows(userFile);
+    }
+
+    return userFile.close();
+}
+
+
+/**
+ * Saves the snapshot in the binary profile format. The file is replaced in
+ * one step once it has been written in full.
+ * @param filename The full path and name of the file
+ * @return True if the save was successful, false otherwise.
+ */
+bool ProfileSnapshot::saveBinaryProfile(string filename) const
+{
+    // Work out where each section will start, so that the table of contents
+    // can be written first and the file written from start to end.
+    uint64_t offset = 4 + 2 * sizeof(uint32_t) +
+                      sizeof(uint32_t) + username.size() +
+                      sizeof(uint32_t) + fullName.size();
+
+    for(size_t i = 0; i < sections.size(); i++)
+    {
+        const LanguagePair &lp = sections[i].languages;
+        offset += 2 * sizeof(uint32_t) + lp.lang1.size() + lp.lang2.size() +
+                  sizeof(uint32_t) + sizeof(uint64_t);
+    }
+
+    vector<uint64_t> sectionOffsets;
+    for(size_t i = 0; i < sections.size(); i++)
+    {
+        const ConnectionTable &table = sections[i].connections;
+
+        sectionOffsets.push_back(offset);
+        if(sections[i].rawData != NULL)
+        {
+            offset += sections[i].rawSize;
+            continue;
+        }
+
+        uint64_t wordsSize = 0;
+        for(size_t row = 0; row < table.size(); row++)
+            wordsSize += table.getWord1(row).size() + table.getWord2(row).size();
+
+        offset += sizeof(uint32_t) +
+                  (2 * table.size() + 1) * sizeof(uint32_t) +
+                  table.size() * (sizeof(int32_t) + sizeof(int64_t)) +
+                  wordsSize;
+    }
+
+    BufferedWriter userFile;
+
+    // Check for failed file open
+    if(!userFile.open(filename))
+        return false;
+
+    userFile.write(PROFILE_MAGIC, 4);
+    userFile.writeValue<uint32_t>(PROFILE_VERSION);
+    userFile.writeValue<uint32_t>(sections.size());
+    userFile.writeString(username);
+    userFile.writeString(fullName);
+
+    for(size_t i = 0; i < sections.size(); i++)
+    {
+        const LanguagePair &lp = sections[i].languages;
+
+        userFile.writeString(lp.lang1);
+        userFile.writeString(lp.lang2);
+        userFile.writeValue<uint32_t>(lp.homeLang);
+        userFile.writeValue<uint64_t>(sectionOffsets[i]);
+    }
+
+    // Each column is written straight from the table in one pass
+    for(size_t i = 0; i < sections.size(); i++)
+    {
+        const ConnectionTable &table = sections[i].connections;
+        size_t row;
+
+        if(sections[i].rawData != NULL)
+        {
+            userFile.write(sections[i].rawData, sections[i].rawSize);
+            continue;
+        }
+
+        userFile.writeValue<uint32_t>(table.size());
+
+        uint32_t wordOffset = 0;
+        for(row = 0; row < table.size(); row++)
+        {
+            userFile.writeValue<uint32_t>(wordOffset);
+            wordOffset += table.getWord1(row).size();
+            userFile.writeValue<uint32_t>(wordOffset);
+            wordOffset += table.getWord2(row).size();
+        }
+        userFile.writeValue<uint32_t>(wordOffset);
+
+        for(row = 0; row < table.size(); row++)
+            userFile.writeValue<int32_t>(table.getUserProficiency(row));
+        for(row = 0; row < table.size(); row++)
+            userFile.writeValue<int64_t>(table.getLastQuizzed(row));
+
+        for(row = 0; row < table.size(); row++)
+        {
+            userFile.write(table.getWord1(row));
+            userFile.write(table.getWord2(row));
+        }
+    }
+
+    // A mismatch would mean the offsets in the table of contents are wrong
+    if(userFile.position() != offset)
+    {
+        userFile.discard();
+        return false;
+    }
+
+    return userFile.close();
+}
@@ -0,0 +1,59 @@
+/**
+ * @file profilesnapshot.hpp
+ * @brief Header definitions for the ProfileSnapshot class.
+ * @author Alex Zirbel
+ */
+
+#ifndef PROFILESNAPSHOT_H
+#define PROFILESNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "connectiontable.hpp"
+#include "languagepair.hpp"
+#include "wordpool.hpp"
+
+/**
+ * One master list of a profile, as it was when the snapshot was taken.
+ */
+struct SnapshotSection
+{
+    LanguagePair languages;
+    ConnectionTable connections;
+
+    //! For a list which was never loaded from the binary profile file, the
+    //! list as it is stored there, and the mapped file which holds it.
+    boost::shared_ptr<boost::interprocess::mapped_region> rawFile;
+    const char *rawData;
+    size_t rawSize;
+};
+
+class ProfileSnapshot
+{
+std::string username;
+std::string fullName;
+
+//! Keeps the words of every row alive, even if the profile is deleted
+//! before the snapshot has been saved.
+boost::shared_ptr<WordPool> wordPool;
+
+std::vector<SnapshotSection> sections;
+
+public:
+    ProfileSnapshot(std::string myUsername, std::string myFullName,
+                    boost::shared_ptr<WordPool> pool);
+
+    void addSection(const LanguagePair &languages,
+                    const ConnectionTable &connections);
+    void addRawSection(const LanguagePair &languages,
+                       boost::shared_ptr<boost::interprocess::mapped_region> file,
+                       const char *data, size_t size);
+
+    bool saveProfile(std::string filename) const;
+    bool saveBinaryProfile(std::string filename) const;
+};
+
+#endif // PROFILESNAPSHOT_H
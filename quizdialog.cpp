@@ -33,6 +33,15 @@ QuizDialog::QuizDialog(QuizList *myList, QWidget *parent) : QDialog(parent)
 
     caseCheckBox = new QCheckBox(tr("Case &Sensitive"));
     reverseCheckBox = new QCheckBox(tr("Reverse &Direction"));
+    typoCheckBox = new QCheckBox(tr("Forgive &Typos"));
+    completeCheckBox = new QCheckBox(tr("&Autocomplete"));
+
+    // The completions are looked up as the user types, so the completer
+    // shows them all rather than filtering them itself.
+    completions = new QStringListModel(this);
+    completer = new QCompleter(completions, this);
+    completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    completer->setWidget(answer);
 
     checkButton = new QPushButton(tr("&Check"));
     checkButton->setDefault(false);
@@ -47,6 +56,10 @@ QuizDialog::QuizDialog(QuizList *myList, QWidget *parent) : QDialog(parent)
             this, SLOT(checkAnswer()));
     connect(resetButton, SIGNAL(clicked()),
             this, SLOT(resetClicked()));
+    connect(answer, SIGNAL(textEdited(const QString&)),
+            this, SLOT(updateCompletions(const QString&)));
+    connect(completer, SIGNAL(activated(const QString&)),
+            answer, SLOT(setText(const QString&)));
 
     // The layout is broken up into three horizontal sections, each of which is
     // split as necessary into vertical secitons.
@@ -62,6 +75,8 @@ QuizDialog::QuizDialog(QuizList *myList, QWidget *parent) : QDialog(parent)
     QVBoxLayout *optionsBox = new QVBoxLayout;
     optionsBox->addWidget(caseCheckBox);
     optionsBox->addWidget(reverseCheckBox);
+    optionsBox->addWidget(typoCheckBox);
+    optionsBox->addWidget(completeCheckBox);
 
     QVBoxLayout *resetsBox = new QVBoxLayout;
     resetsBox->addWidget(resetButton);
@@ -93,14 +108,27 @@ QuizDialog::QuizDialog(QuizList *myList, QWidget *parent) : QDialog(parent)
     // Initialize the quiz to be run in this widget
     //! @todo Guard against accessing this before loadDictionary is called.
     quiz = new FillInVocabQuiz(myList);
+    list = myList;
+    wordCompleter = NULL;
+    completerDirection = STANDARD;
     getNextPrompt();
 }
 
 QuizDialog::~QuizDialog()
 {
+    delete wordCompleter;
     cout << "Quiz Dialog object destroyed." << endl;
 }
 
+/**
+ * Records every answer given in this dialog in the user's answer journal.
+ * @param journal The journal of the logged in profile
+ */
+void QuizDialog::setJournal(AnswerJournal *journal)
+{
+    quiz->setJournal(journal);
+}
+
 /**
  * Checks the answer currently typed into the lineEdit answer box.
  * If the quiz as currently set up accepts this as an answer (or if not),
@@ -127,6 +155,14 @@ void QuizDialog::checkAnswer()
     else
         quiz->setCaseSensitive(false);
 
+    if(typoCheckBox->isChecked())
+        quiz->setMaxTypos(DEFAULT_MAX_TYPOS);
+    else
+        quiz->setMaxTypos(0);
+
+    // Checking the answer finishes with the prompt, so look up its answer first
+    string correctAnswer = quiz->getCorrectAnswer();
+
     if(quiz->checkAnswer(text.toStdString()))
     {
         info->setText("Correct!");
@@ -134,7 +170,7 @@ void QuizDialog::checkAnswer()
     else
     {
         string response = "Wrong - \"" + curPrompt + "\" is: \"" +
-                          quiz->getCorrectAnswer() + "\".";
+                          correctAnswer + "\".";
         info->setText(QString(response.c_str()));
     }
 
@@ -152,6 +188,43 @@ void QuizDialog::resetClicked()
     getNextPrompt();
 }
 
+/**
+ * Offers the words of the answer language starting with what has been typed,
+ * if autocomplete is turned on. The words are collected the first time they
+ * are needed, and again only if the quiz direction changes.
+ * @param text The answer typed so far
+ */
+void QuizDialog::updateCompletions(const QString &text)
+{
+    if(!completeCheckBox->isChecked() || text.isEmpty())
+    {
+        completer->popup()->hide();
+        return;
+    }
+
+    int direction = quiz->getDirection();
+    if(wordCompleter == NULL || completerDirection != direction)
+    {
+        delete wordCompleter;
+        wordCompleter = new WordCompleter(list, direction == REVERSE);
+        completerDirection = direction;
+    }
+
+    vector<string> words;
+    wordCompleter->complete(text.toStdString(), DEFAULT_MAX_COMPLETIONS,
+                            words);
+
+    QStringList items;
+    for(size_t i = 0; i < words.size(); i++)
+        items << QString(words[i].c_str());
+    completions->setStringList(items);
+
+    if(items.isEmpty())
+        completer->popup()->hide();
+    else
+        completer->complete();
+}
+
 /**
  * Sets up the quiz for the next prompt and sets it as the current prompt
  * At this point, changes direction of the quiz in case it was changed during
@@ -3,12 +3,15 @@
 
 #include <QDialog>
 #include "vocabquiz.hpp"
+#include "wordcompleter.hpp"
 #include <boost/lexical_cast.hpp>
 
 class QCheckBox;
+class QCompleter;
 class QLabel;
 class QLineEdit;
 class QPushButton;
+class QStringListModel;
 
 class QuizDialog : public QDialog
 {
@@ -17,16 +20,22 @@ class QuizDialog : public QDialog
 // The backend quiz object being used in this gui quiz interace.
 
 FillInVocabQuiz *quiz;
+QuizList *list;
+// Completes answers from the words of the list, built when first needed.
+WordCompleter *wordCompleter;
+int completerDirection;
 std::string curPrompt;
 int numCorrect, numWrong;
 
 public:
     QuizDialog(QuizList *myList, QWidget *parent = 0);
     ~QuizDialog();
+    void setJournal(AnswerJournal *journal);
 
 private slots:
     void checkAnswer();
     void resetClicked();
+    void updateCompletions(const QString &text);
 
 private:
     QLabel *listName;
@@ -36,6 +45,10 @@ private:
     QLineEdit *answer;
     QCheckBox *caseCheckBox;
     QCheckBox *reverseCheckBox;
+    QCheckBox *typoCheckBox;
+    QCheckBox *completeCheckBox;
+    QCompleter *completer;
+    QStringListModel *completions;
     QPushButton *checkButton;
     QPushButton *resetButton;
     void getNextPrompt();
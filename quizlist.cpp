@@ -20,16 +20,342 @@
  */
 
 #include "quizlist.hpp"
+#include "casefold.hpp"
+#include "fieldscanner.hpp"
+#include "bufferedwriter.hpp"
+#include "compactdictionary.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/thread/thread.hpp>
 
 using namespace std;
 using namespace boost;
+using boost::posix_time::ptime;
+using boost::posix_time::microsec_clock;
+using boost::interprocess::mapped_region;
+
+/**
+ * Maps a whole file into memory for reading.
+ * @param filename The file to map
+ * @param region Receives the mapping
+ * @return False if the file could not be mapped, which includes missing and
+ *  empty files.
+ */
+static bool mapFile(const string &filename, mapped_region &region)
+{
+    using namespace boost::interprocess;
+
+    try
+    {
+        file_mapping mapping(filename.c_str(), read_only);
+        mapped_region mapped(mapping, read_only);
+        region.swap(mapped);
+    }
+    catch(interprocess_exception &)
+    {
+        return false;
+    }
+
+    region.advise(mapped_region::advice_sequential);
+    return true;
+}
+
+/**
+ * Returns the number of seconds elapsed since start.
+ */
+static double secondsSince(ptime start)
+{
+    return (microsec_clock::universal_time() - start).total_microseconds()
+            / 1000000.0;
+}
+
+
+/**
+ * One line of a dictionary file, as views into the mapped file.
+ */
+struct ParsedLine
+{
+    string_ref word1;
+    string_ref word2;
+};
 
 /**
- * Resets the QuizList to the beginning of the list
+ * Parses one chunk of a mapped dictionary file on a worker thread. A chunk
+ * always starts at the beginning of a line and ends just past a newline or
+ * at the end of the file. Lines are collected into a buffer owned by the
+ * chunk, in file order.
+ */
+struct ChunkParser
+{
+    const char *begin;
+    const char *end;
+    vector<ParsedLine> lines;
+    bool failed;
+
+    ChunkParser()
+    {
+        begin = end = NULL;
+        failed = false;
+    }
+
+    void operator()()
+    {
+        const char *pos = begin;
+
+        while(pos != end)
+        {
+            const char *lineEnd = findLineEnd(pos, end);
+
+            // Like the serial loader, ignore a final line which is not
+            // terminated by a newline.
+            if(lineEnd == end)
+                break;
+
+            // Make sure there are at least two tokens; ignore any additional
+            ParsedLine line;
+            FieldScanner fields(pos, lineEnd);
+            if(!fields.next(line.word1) || !fields.next(line.word2))
+            {
+                failed = true;
+                return;
+            }
+
+            lines.push_back(line);
+            pos = lineEnd + 1;
+        }
+    }
+};
+
+
+//! Lists with fewer connections than this are sorted on the calling thread.
+#define PARALLEL_SORT_THRESHOLD 50000
+
+/**
+ * The sort key of one row when sorting alphabetically. The first eight
+ * bytes of the case folded word are packed into an integer once, so that
+ * most comparisons never look at the word or fold its case.
+ */
+struct CollationKey
+{
+    //! The first eight bytes of the folded word, most significant first
+    uint64_t prefix;
+    const string *word;
+    size_t row;
+
+    CollationKey(const string *myWord, size_t myRow)
+    {
+        word = myWord;
+        row = myRow;
+        prefix = 0;
+
+        size_t length = (word->size() < 8) ? word->size() : 8;
+        for(size_t i = 0; i < length; i++)
+        {
+            // Past ASCII, folding can change the bytes; fold the word
+            if((*word)[i] & 0x80)
+            {
+                setPrefix(foldCase(*word));
+                return;
+            }
+        }
+
+        setPrefix(*word);
+    }
+
+    void setPrefix(const string &text)
+    {
+        prefix = 0;
+        for(size_t i = 0; i < 8; i++)
+        {
+            prefix <<= 8;
+            if(i < text.size())
+                prefix |= (unsigned char) foldAsciiCase(text[i]);
+        }
+    }
+};
+
+/**
+ * Orders keys by folded word, byte by byte, then by row so that the sort is
+ * stable.
+ */
+static bool collatesBefore(const CollationKey &a, const CollationKey &b)
+{
+    if(a.prefix != b.prefix)
+        return a.prefix < b.prefix;
+
+    // Equal words from one pool share a handle
+    if(a.word != b.word)
+    {
+        int order = caseInsensitiveCompare(*a.word, *b.word);
+        if(order != 0)
+            return order < 0;
+    }
+
+    return a.row < b.row;
+}
+
+/**
+ * Sorts, or merges two sorted halves of, a range of keys on a worker
+ * thread. With middle equal to begin, the range is sorted.
+ */
+struct CollationTask
+{
+    vector<CollationKey>::iterator begin, middle, end;
+
+    void operator()()
+    {
+        if(middle == begin)
+            std::sort(begin, end, collatesBefore);
+        else
+            std::inplace_merge(begin, middle, end, collatesBefore);
+    }
+};
+
+/**
+ * Sorts collation keys on every core: each thread sorts an equal share,
+ * then neighbouring shares are merged in pairs, in parallel, until one is
+ * left.
+ */
+static void parallelSort(vector<CollationKey> &keys)
+{
+    unsigned int numThreads = boost::thread::hardware_concurrency();
+    if(numThreads == 0 || keys.size() < PARALLEL_SORT_THRESHOLD)
+        numThreads = 1;
+
+    vector<vector<CollationKey>::iterator> bounds;
+    for(unsigned int i = 0; i <= numThreads; i++)
+        bounds.push_back(keys.begin() + keys.size() * i / numThreads);
+
+    // Sort each share
+    vector<CollationTask> tasks(numThreads);
+    for(unsigned int i = 0; i < numThreads; i++)
+    {
+        tasks[i].begin = tasks[i].middle = bounds[i];
+        tasks[i].end = bounds[i + 1];
+    }
+
+    // Then merge neighbouring shares until the whole range is sorted. A
+    // share without a neighbour waits for the next round.
+    while(true)
+    {
+        thread_group workers;
+        for(size_t i = 1; i < tasks.size(); i++)
+            workers.create_thread(tasks[i]);
+        tasks[0]();
+        workers.join_all();
+
+        if(bounds.size() <= 2)
+            break;
+
+        vector<vector<CollationKey>::iterator> next;
+        tasks.clear();
+
+        size_t i;
+        for(i = 0; i + 2 < bounds.size(); i += 2)
+        {
+            CollationTask merge;
+            merge.begin = bounds[i];
+            merge.middle = bounds[i + 1];
+            merge.end = bounds[i + 2];
+            tasks.push_back(merge);
+            next.push_back(bounds[i]);
+        }
+        for(; i < bounds.size(); i++)
+            next.push_back(bounds[i]);
+
+        bounds.swap(next);
+    }
+}
+
+/**
+ * Sorts row indices by unsigned integer keys with a least significant digit
+ * radix sort, a byte at a time. Passes over bytes which are the same in
+ * every key are skipped, so a proficiency sort is one pass. Rows with equal
+ * keys keep their order.
+ * @param keys The key of each row
+ * @return The rows in order of their keys
+ */
+static vector<size_t> radixSortRows(const vector<uint64_t> &keys)
+{
+    size_t count = keys.size();
+    vector<size_t> order(count), scratch(count);
+
+    for(size_t row = 0; row < count; row++)
+        order[row] = row;
+
+    for(int shift = 0; shift < 64; shift += 8)
+    {
+        size_t buckets[257] = { 0 };
+
+        for(size_t row = 0; row < count; row++)
+            buckets[((keys[row] >> shift) & 0xFF) + 1]++;
+
+        // Every key has the same byte here; the pass would change nothing
+        bool trivial = false;
+        for(int b = 1; b <= 256; b++)
+        {
+            if(buckets[b] == count)
+                trivial = true;
+        }
+        if(trivial)
+            continue;
+
+        for(int b = 1; b <= 256; b++)
+            buckets[b] += buckets[b - 1];
+
+        for(size_t i = 0; i < count; i++)
+        {
+            size_t row = order[i];
+            scratch[buckets[(keys[row] >> shift) & 0xFF]++] = row;
+        }
+
+        order.swap(scratch);
+    }
+
+    return order;
+}
+
+/**
+ * Maps a signed value onto an unsigned key which sorts in the same order.
+ */
+static uint64_t orderedKey(int64_t value)
+{
+    return (uint64_t) value ^ ((uint64_t) 1 << 63);
+}
+
+
+LoadStatistics::LoadStatistics()
+{
+    wordsLoaded = 0;
+    seconds = 0;
+}
+
+
+/**
+ * The load rate of the last load, or 0 if nothing was timed.
+ */
+double LoadStatistics::wordsPerSecond() const
+{
+    if(seconds <= 0)
+        return 0;
+
+    return wordsLoaded / seconds;
+}
+
+/**
+ * Resets the QuizList to the beginning of the list and gives it a word pool
+ * of its own.
  */
 QuizList::QuizList()
 {
-    listItr = connList.begin();
+    listPos = 0;
+    wordPool.reset(new WordPool);
 }
 
 
@@ -38,7 +364,7 @@ QuizList::QuizList()
  */
 MasterList::MasterList()
 {
-    listItr = connList.begin();
+    listPos = 0;
 }
 
 
@@ -52,6 +378,20 @@ MasterList::MasterList(LanguagePair languages)
 }
 
 
+/**
+ * Sets the master list to the specified languages, storing its words in a
+ * pool shared with other lists.
+ * @param languages The languages of the list
+ * @param pool The pool to store words in, usually the user profile's
+ */
+MasterList::MasterList(LanguagePair languages, shared_ptr<WordPool> pool)
+{
+    lang1 = languages.lang1;
+    lang2 = languages.lang2;
+    wordPool = pool;
+}
+
+
 /**
  * Builds a MasterList as a duplicate of an existing MasterList.
  * Simply copies the fields.
@@ -62,8 +402,15 @@ MasterList::MasterList(MasterList* existing)
     lang1 = existing->lang1;
     lang2 = existing->lang2;
     listName = existing->listName;
-    connList = existing->connList;
-    listItr = existing->listItr;
+    connections = existing->connections;
+    listPos = existing->listPos;
+    wordPool = existing->wordPool;
+    exactIndex = existing->exactIndex;
+    foldedIndex = existing->foldedIndex;
+    word1Rows = existing->word1Rows;
+    word2Rows = existing->word2Rows;
+    foldedWord1Rows = existing->foldedWord1Rows;
+    foldedWord2Rows = existing->foldedWord2Rows;
 }
 
 
@@ -73,6 +420,7 @@ MasterList::MasterList(MasterList* existing)
  */
 void QuizList::sortByLang1()
 {
+    sortByWords(true);
 }
 
 /**
@@ -81,6 +429,7 @@ void QuizList::sortByLang1()
  */
 void QuizList::sortByLang2()
 {
+    sortByWords(false);
 }
 
 /**
@@ -89,6 +438,13 @@ void QuizList::sortByLang2()
  */
 void QuizList::sortByLeastKnown()
 {
+    const vector<int> &proficiency = connections.proficiencyColumn();
+    vector<uint64_t> keys(proficiency.size());
+
+    for(size_t row = 0; row < keys.size(); row++)
+        keys[row] = orderedKey(proficiency[row]);
+
+    reorder(radixSortRows(keys));
 }
 
 /**
@@ -97,8 +453,13 @@ void QuizList::sortByLeastKnown()
  */
 void QuizList::sortByMostKnown()
 {
-    sortByLeastKnown();
-    connList.reverse();
+    const vector<int> &proficiency = connections.proficiencyColumn();
+    vector<uint64_t> keys(proficiency.size());
+
+    for(size_t row = 0; row < keys.size(); row++)
+        keys[row] = ~orderedKey(proficiency[row]);
+
+    reorder(radixSortRows(keys));
 }
 
 /*
@@ -112,9 +473,19 @@ int nextElementNum = *listItr;
 quizList.erase( quizList.find(nextElementNum) );
 */
 
-//! Unimplemented until connection's last quizzed variable is implemented
+/**
+ * Sort the words so that the word quizzed longest ago comes first, and
+ * words which have never been quizzed come before all of them.
+ */
 void QuizList::sortByLastQuizzed()
 {
+    const vector<time_t> &lastQuizzed = connections.lastQuizzedColumn();
+    vector<uint64_t> keys(lastQuizzed.size());
+
+    for(size_t row = 0; row < keys.size(); row++)
+        keys[row] = orderedKey(lastQuizzed[row]);
+
+    reorder(radixSortRows(keys));
 }
 
 /**
@@ -122,8 +493,189 @@ void QuizList::sortByLastQuizzed()
  */
 void QuizList::sortByRecentlyQuizzed()
 {
-    sortByLastQuizzed();
-    connList.reverse();
+    const vector<time_t> &lastQuizzed = connections.lastQuizzedColumn();
+    vector<uint64_t> keys(lastQuizzed.size());
+
+    for(size_t row = 0; row < keys.size(); row++)
+        keys[row] = ~orderedKey(lastQuizzed[row]);
+
+    reorder(radixSortRows(keys));
+}
+
+/**
+ * Sorts the words alphabetically, ignoring case, by the words in one of the
+ * languages. A key is built from each word's folded form once, rather than
+ * folding case on every comparison, and the sort runs on every core. Words which
+ * are the same ignoring case keep their order.
+ * @param byWord1 True to sort by the first language, false by the second
+ */
+void QuizList::sortByWords(bool byWord1)
+{
+    vector<CollationKey> keys;
+    keys.reserve(connections.size());
+
+    for(size_t row = 0; row < connections.size(); row++)
+    {
+        keys.push_back(CollationKey(byWord1 ? connections.getWord1Handle(row)
+                                            : connections.getWord2Handle(row),
+                                    row));
+    }
+
+    parallelSort(keys);
+
+    vector<size_t> order(keys.size());
+    for(size_t i = 0; i < keys.size(); i++)
+        order[i] = keys[i].row;
+
+    reorder(order);
+}
+
+/**
+ * Appends a connection to the end of the list and records it in the lookup
+ * indices used by contains(). The connection's words are interned into this
+ * list's pool first, so it may come from anywhere.
+ * @param conn The connection to add
+ */
+void QuizList::addConnection(Connection conn)
+{
+    conn.internInto(*wordPool);
+    addPooledConnection(conn);
+}
+
+/**
+ * Appends a connection whose words are already interned in this list's
+ * pool. All additions to connections should go through this function or
+ * addConnection.
+ * @param conn The connection to add, built with this list's pool
+ */
+void QuizList::addPooledConnection(const Connection &conn)
+{
+    const string *word1 = conn.getWord1Handle();
+    const string *word2 = conn.getWord2Handle();
+
+    size_t row = connections.append(word1, word2, conn.getUserProficiency(),
+                                    (time_t) conn.getLastQuizzed());
+
+    const string *folded1 = wordPool->internFolded(*word1);
+    const string *folded2 = wordPool->internFolded(*word2);
+
+    exactIndex.insert(make_pair(WordPair(word1, word2), row));
+    foldedIndex.insert(WordPair(folded1, folded2));
+
+    word1Rows.insert(make_pair(word1, row));
+    word2Rows.insert(make_pair(word2, row));
+    foldedWord1Rows.insert(make_pair(folded1, row));
+    foldedWord2Rows.insert(make_pair(folded2, row));
+}
+
+/**
+ * Builds a Connection holding the words and statistics of one row. The
+ * connection is a copy: changing it does not change the list.
+ * @param row The row, less than connections.size()
+ */
+Connection QuizList::getConnection(size_t row)
+{
+    return Connection(wordPool->intern(lang1), wordPool->intern(lang2),
+                      connections.getWord1Handle(row),
+                      connections.getWord2Handle(row),
+                      connections.getUserProficiency(row),
+                      connections.getLastQuizzed(row));
+}
+
+/**
+ * Finds the languages of the two word columns. Connections store their words
+ * with the languages in alphabetical order, which need not be the order a
+ * dictionary file named them in, and so the order of lang1 and lang2.
+ * @param first Set to the language of the word1 column
+ * @param second Set to the language of the word2 column
+ */
+void QuizList::getColumnLanguages(string &first, string &second) const
+{
+    if(boost::algorithm::lexicographical_compare(lang2, lang1,
+        boost::is_iless()))
+    {
+        first = lang2;
+        second = lang1;
+    }
+    else
+    {
+        first = lang1;
+        second = lang2;
+    }
+}
+
+
+/**
+ * Finds the row of the connection between two words, matching them exactly.
+ * @param word1 The word in the first language alphabetically
+ * @param word2 The word in the second language alphabetically
+ * @return The first row holding the words, or npos if there is none.
+ */
+size_t QuizList::findConnection(string_ref word1, string_ref word2)
+{
+    const string *handle1 = wordPool->find(word1);
+    const string *handle2 = wordPool->find(word2);
+
+    if(handle1 == NULL || handle2 == NULL)
+        return npos;
+
+    boost::unordered_map<WordPair, size_t>::iterator found =
+            exactIndex.find(WordPair(handle1, handle2));
+
+    return (found == exactIndex.end()) ? npos : found->second;
+}
+
+/**
+ * Rearranges the connections, so that new row i holds what was in row
+ * order[i], and updates the rows recorded in the index to match.
+ * @param order A permutation of the rows
+ */
+void QuizList::reorder(const vector<size_t> &order)
+{
+    connections.reorder(order);
+    rebuildExactIndex(order);
+}
+
+/**
+ * Moves a row index's entries to the rows their connections now occupy.
+ * @param index The index to update
+ * @param newRows The new row of every old row
+ */
+static void remapRows(boost::unordered_multimap<const string*, size_t> &index,
+                      const vector<size_t> &newRows)
+{
+    boost::unordered_multimap<const string*, size_t>::iterator itr;
+    for(itr = index.begin(); itr != index.end(); itr++)
+        itr->second = newRows[itr->second];
+}
+
+/**
+ * Records the current row of every connection in the indices, after the rows
+ * have been rearranged, and restarts the quiz position. The words in the
+ * indices are unchanged, so only the rows are updated in place; going
+ * backwards leaves the first row in exactIndex for words which occur more
+ * than once.
+ * @param order The permutation the rows were rearranged by
+ */
+void QuizList::rebuildExactIndex(const vector<size_t> &order)
+{
+    for(size_t row = connections.size(); row > 0; row--)
+    {
+        WordPair words(connections.getWord1Handle(row - 1),
+                       connections.getWord2Handle(row - 1));
+        exactIndex.find(words)->second = row - 1;
+    }
+
+    vector<size_t> newRows(order.size());
+    for(size_t row = 0; row < order.size(); row++)
+        newRows[order[row]] = row;
+
+    remapRows(word1Rows, newRows);
+    remapRows(word2Rows, newRows);
+    remapRows(foldedWord1Rows, newRows);
+    remapRows(foldedWord2Rows, newRows);
+
+    listPos = 0;
 }
 
 /**
@@ -137,21 +689,123 @@ void QuizList::sortByRecentlyQuizzed()
  * @param conn The connection to check for
  * @param caseSensitive Whether to check for case sensitivity of words.
  */
-bool QuizList::contains(Connection conn, bool caseSensitive)
+bool QuizList::contains(const Connection &conn, bool caseSensitive)
 {
-    list<Connection>::iterator itr;
+    // Every connection in the list shares the list's languages, which are
+    // always compared case insensitive.
+    bool sameOrder = caseInsensitiveEquals(conn.getLang1(), lang1) &&
+                     caseInsensitiveEquals(conn.getLang2(), lang2);
+    bool swapped = caseInsensitiveEquals(conn.getLang1(), lang2) &&
+                   caseInsensitiveEquals(conn.getLang2(), lang1);
+
+    if(!sameOrder && !swapped)
+        return false;
 
-    // Search the list, check each connection.
-    //! @todo Add hashing to make this faster?
-    for(itr = connList.begin(); itr != connList.end(); itr++)
+    return containsWords(conn.getWord1(), conn.getWord2(), caseSensitive);
+}
+
+/**
+ * Check if the QuizList contains a connection between two words, in the
+ * list's languages. The check is a few hash lookups, so it costs the same
+ * regardless of the size of the list, and it never adds the words to the
+ * list's pool.
+ *
+ * @param word1 The word in the first language alphabetically
+ * @param word2 The word in the second language alphabetically
+ * @param caseSensitive Whether to check for case sensitivity of words.
+ */
+bool QuizList::containsWords(const string &word1, const string &word2,
+                             bool caseSensitive)
+{
+    const string *handle1, *handle2;
+
+    if(caseSensitive)
     {
-        if(conn.basicEquals(*itr, caseSensitive))
-        {
-            return true;
-        }
+        handle1 = wordPool->find(word1);
+        handle2 = wordPool->find(word2);
     }
+    else
+    {
+        handle1 = wordPool->findFolded(word1);
+        handle2 = wordPool->findFolded(word2);
+    }
+
+    if(handle1 == NULL || handle2 == NULL)
+        return false;
 
-    return false;
+    if(caseSensitive)
+        return exactIndex.count(WordPair(handle1, handle2)) != 0;
+    else
+        return foldedIndex.find(WordPair(handle1, handle2))
+                != foldedIndex.end();
+}
+
+/**
+ * Finds every word the list connects to a word. Case insensitive searches
+ * return the case-folded translations. The rows come from an index, so the
+ * search takes as long as the word has translations, whatever the size of
+ * the list.
+ *
+ * @param word The word to translate
+ * @param fromWord1 True if word is in the first language, false if second
+ * @param caseSensitive Whether to check for case sensitivity of words.
+ * @param translations Where the pooled translations are appended
+ */
+void QuizList::findTranslations(const string &word, bool fromWord1,
+                                bool caseSensitive,
+                                vector<const string*> &translations)
+{
+    const string *handle;
+    if(caseSensitive)
+        handle = wordPool->find(word);
+    else
+        handle = wordPool->findFolded(word);
+    if(handle == NULL)
+        return;
+
+    const RowIndex &index = caseSensitive ? (fromWord1 ? word1Rows : word2Rows)
+                                          : (fromWord1 ? foldedWord1Rows
+                                                       : foldedWord2Rows);
+
+    pair<RowIndex::const_iterator, RowIndex::const_iterator> rows =
+            index.equal_range(handle);
+
+    for(RowIndex::const_iterator itr = rows.first; itr != rows.second; itr++)
+    {
+        const string *translation = fromWord1
+                ? connections.getWord2Handle(itr->second)
+                : connections.getWord1Handle(itr->second);
+
+        // Every word of the list has had its folded form pooled
+        if(!caseSensitive)
+            translation = wordPool->findFolded(*translation);
+
+        translations.push_back(translation);
+    }
+}
+
+/**
+ * Estimates the memory taken by a hash index: its bucket table, and one heap
+ * node per entry holding the entry and the links between nodes.
+ */
+template <typename Index>
+static size_t indexBytes(const Index &index)
+{
+    return heapBlockBytes((index.bucket_count() + 1) * sizeof(void*)) +
+           index.size() * heapBlockBytes(sizeof(typename Index::value_type) +
+                                         2 * sizeof(void*));
+}
+
+/**
+ * Estimates the memory taken by the list's rows and indices, not counting
+ * the words themselves, which belong to the shared pool.
+ */
+size_t QuizList::bytesUsed() const
+{
+    return sizeof(*this) + connections.bytesUsed() +
+           indexBytes(exactIndex) + indexBytes(foldedIndex) +
+           indexBytes(word1Rows) + indexBytes(word2Rows) +
+           indexBytes(foldedWord1Rows) + indexBytes(foldedWord2Rows);
 }
 
 /**
@@ -169,6 +823,9 @@ bool MasterList::importDictionaryFromFile(std::string filename)
     /** @todo When the file reading fails, should this function return false
         or throw an exception? Right now it throws an exception. */
 
+    ptime start = microsec_clock::universal_time();
+    size_t sizeBefore = connections.size();
+
     // Temporarily holds lines read from the file
     string line;
 
@@ -188,20 +845,16 @@ bool MasterList::importDictionaryFromFile(std::string filename)
     if(dictFile.eof())
         throw new LoadFileException;
 
-    // Tokenize based on tab characters
-    char_separator <char> sep("\t");
-    tokenizer <char_separator <char> > tokens(line, sep);
-    tokenizer<char_separator <char> >::iterator itr = tokens.begin();
-
     // Make sure there are at least two tokens; ignore any additional
-    lang1 = *itr;
-    itr++;
-    if(itr == tokens.end())
+    FieldScanner languageFields(line);
+    string_ref field1, field2;
+    if(!languageFields.next(field1) || !languageFields.next(field2))
         throw new LoadFileException;
-    lang2 = *itr;
+    lang1 = field1.to_string();
+    lang2 = field2.to_string();
 
     // Check to see if the languages are equal (this is not allowed)
-    if(boost::iequals(lang1, lang2))
+    if(caseInsensitiveEquals(lang1, lang2))
         throw new LoadFileException;
 
     // Read the entire dictionary file
@@ -212,23 +865,130 @@ bool MasterList::importDictionaryFromFile(std::string filename)
         if(dictFile.eof())
             break;
 
-        // Tokenize based on tab characters
-        tokenizer <char_separator <char> > tokens(line, sep);
-        tokenizer<char_separator <char> >::iterator itr = tokens.begin();
-
         // Make sure there are at least two tokens; ignore any additional
-        string word1 = *itr;
-        itr++;
-        if(itr == tokens.end())
+        FieldScanner fields(line);
+        if(!fields.next(field1) || !fields.next(field2))
             throw new LoadFileException;
-        string word2 = *itr;
 
         // Create a Connection and add it to the master list
-        Connection *conn = new Connection(lang1, lang2, word1, word2);
-        connList.push_back(*conn);
+        addPooledConnection(Connection(*wordPool, lang1, lang2,
+                                       field1, field2));
     }
 
     dictFile.close();
+
+    lastLoad.wordsLoaded = connections.size() - sizeBefore;
+    lastLoad.seconds = secondsSince(start);
+    return true;
+}
+
+/**
+ * Builds a master list out of a text file in the same format as
+ * importDictionaryFromFile, parsing the file on several threads.
+ *
+ * The file is mapped into memory and split into chunks at newline
+ * boundaries. Each chunk is parsed on its own thread into a buffer of views
+ * into the file; the buffers are then added to the list in the original
+ * order, so the result is identical to the serial import. Adding to the list
+ * interns words into the shared pool and stays on the calling thread.
+ * @param filename The location of the text file to load
+ * @param numThreads How many threads to parse with, or 0 to use one per core
+ * @return True if the load was successful
+ */
+bool MasterList::importDictionaryFromFile(std::string filename,
+                                          unsigned int numThreads)
+{
+    ptime start = microsec_clock::universal_time();
+    size_t sizeBefore = connections.size();
+
+    mapped_region region;
+    if(!mapFile(filename, region))
+        throw new LoadFileException;
+
+    const char *pos = (const char*) region.get_address();
+    const char *end = pos + region.get_size();
+    const char *lineEnd;
+    string_ref field1, field2;
+
+    // The first line of the file is the dictionary name
+    lineEnd = findLineEnd(pos, end);
+    listName.assign(pos, lineEnd);
+    if(lineEnd == end)
+        throw new LoadFileException;
+    pos = lineEnd + 1;
+
+    // Read the languages from the second line
+    lineEnd = findLineEnd(pos, end);
+    if(lineEnd == end)
+        throw new LoadFileException;
+    FieldScanner languageFields(pos, lineEnd);
+    if(!languageFields.next(field1) || !languageFields.next(field2))
+        throw new LoadFileException;
+    lang1 = field1.to_string();
+    lang2 = field2.to_string();
+
+    // Check to see if the languages are equal (this is not allowed)
+    if(caseInsensitiveEquals(lang1, lang2))
+        throw new LoadFileException;
+
+    pos = lineEnd + 1;
+
+    if(numThreads == 0)
+        numThreads = boost::thread::hardware_concurrency();
+    if(numThreads == 0)
+        numThreads = 1;
+
+    // Split the rest of the file into chunks which end on line boundaries
+    vector<ChunkParser> chunks(numThreads);
+    size_t chunkSize = (end - pos) / numThreads;
+
+    for(unsigned int i = 0; i < numThreads; i++)
+    {
+        chunks[i].begin = pos;
+
+        if(i == numThreads - 1 || (size_t)(end - pos) <= chunkSize)
+            pos = end;
+        else
+        {
+            lineEnd = findLineEnd(pos + chunkSize, end);
+            pos = (lineEnd == end) ? end : lineEnd + 1;
+        }
+
+        chunks[i].end = pos;
+    }
+
+    thread_group workers;
+    for(unsigned int i = 1; i < numThreads; i++)
+        workers.create_thread(boost::ref(chunks[i]));
+
+    // The calling thread takes the first chunk itself
+    chunks[0]();
+    workers.join_all();
+
+    for(unsigned int i = 0; i < numThreads; i++)
+    {
+        if(chunks[i].failed)
+            throw new LoadFileException;
+    }
+
+    // Splice the chunks into the list in file order
+    size_t numLines = 0;
+    for(unsigned int i = 0; i < numThreads; i++)
+        numLines += chunks[i].lines.size();
+    connections.reserve(connections.size() + numLines);
+
+    for(unsigned int i = 0; i < numThreads; i++)
+    {
+        vector<ParsedLine>::iterator itr;
+        for(itr = chunks[i].lines.begin(); itr != chunks[i].lines.end(); itr++)
+        {
+            addPooledConnection(Connection(*wordPool, lang1, lang2,
+                                           itr->word1, itr->word2));
+        }
+    }
+
+    lastLoad.wordsLoaded = connections.size() - sizeBefore;
+    lastLoad.seconds = secondsSince(start);
     return true;
 }
 
@@ -239,10 +999,10 @@ void MasterList::printContents()
 {
     cout << "Master List: " << listName << endl;
     cout << "Languages: " << lang1 << ", " << lang2 << endl;
-    for(listItr = connList.begin(); listItr != connList.end(); listItr++)
+    for(size_t row = 0; row < connections.size(); row++)
     {
-        Connection conn = *listItr;
-        cout << "  " << conn.getWord1() << " <==> " << conn.getWord2() << endl;
+        cout << "  " << connections.getWord1(row) << " <==> "
+             << connections.getWord2(row) << endl;
     }
 }
 
@@ -259,6 +1019,9 @@ bool MasterList::loadFromFile(std::string filename)
     /** @todo When the file reading fails, should this function return false
         or throw an exception? Right now it returns false. */
 
+    ptime start = microsec_clock::universal_time();
+    size_t sizeBefore = connections.size();
+
     // Temporarily holds lines read from the file
     string line;
 
@@ -278,20 +1041,16 @@ bool MasterList::loadFromFile(std::string filename)
     if(dictFile.eof())
         return false;
 
-    // Tokenize based on tab characters
-    char_separator <char> sep("\t");
-    tokenizer <char_separator <char> > tokens(line, sep);
-    tokenizer<char_separator <char> >::iterator itr = tokens.begin();
-
     // Make sure there are at least two tokens; ignore any additional
-    lang1 = *itr;
-    itr++;
-    if(itr == tokens.end())
-        throw new LoadFileException;
-    lang2 = *itr;
+    FieldScanner languageFields(line);
+    string_ref field1, field2;
+    if(!languageFields.next(field1) || !languageFields.next(field2))
+        return false;
+    lang1 = field1.to_string();
+    lang2 = field2.to_string();
 
     // Check to see if the languages are equal (this is not allowed)
-    if(boost::iequals(lang1, lang2))
+    if(caseInsensitiveEquals(lang1, lang2))
         return false;
 
     // Read the entire dictionary file
@@ -302,43 +1061,159 @@ bool MasterList::loadFromFile(std::string filename)
         if(dictFile.eof())
             break;
 
-        // Tokenize based on tab characters
-        tokenizer <char_separator <char> > tokens(line, sep);
-        tokenizer<char_separator <char> >::iterator itr = tokens.begin();
-
         // Make sure there are at least two tokens; ignore any additional
-        string word1 = *itr;
-        itr++;
-        if(itr == tokens.end())
+        FieldScanner fields(line);
+        if(!fields.next(field1) || !fields.next(field2))
             return false;
-        string word2 = *itr;
 
         // Create a Connection and add it to the master list
-        Connection *conn = new Connection(lang1, lang2, word1, word2);
-        connList.push_back(*conn);
+        addPooledConnection(Connection(*wordPool, lang1, lang2,
+                                       field1, field2));
     }
 
     dictFile.close();
+
+    lastLoad.wordsLoaded = connections.size() - sizeBefore;
+    lastLoad.seconds = secondsSince(start);
     return true;
 }
 
-//! @todo Implement
-bool MasterList::saveToFile(std::string filename)
+/**
+ * Loads a master list from a text file in the same format as loadFromFile,
+ * but maps the file into memory instead of reading it line by line. Words
+ * are copied straight out of the mapped bytes into their connections, so
+ * no temporary strings are built for lines or tokens.
+ *
+ * Unlike loadFromFile, a final line without a trailing newline is kept.
+ * @param filename The location of the text file to load
+ * @return True if the load was successful, false otherwise
+ */
+bool MasterList::loadFromMappedFile(std::string filename)
 {
-    ofstream dictFile;
-    dictFile.open(filename.c_str(), ofstream::out);
+    ptime start = microsec_clock::universal_time();
+    unsigned long wordsLoaded = 0;
 
-    // Check for failed file open
-    if(!dictFile.is_open())
+    mapped_region region;
+    if(!mapFile(filename, region))
+        return false;
+
+    const char *pos = (const char*) region.get_address();
+    const char *end = pos + region.get_size();
+    const char *lineEnd;
+    string_ref field1, field2;
+
+    // The first line of the file is the dictionary name
+    lineEnd = findLineEnd(pos, end);
+    listName.assign(pos, lineEnd);
+    if(lineEnd == end)
+        return false;
+    pos = lineEnd + 1;
+
+    // Read the languages from the second line
+    lineEnd = findLineEnd(pos, end);
+    FieldScanner languageFields(pos, lineEnd);
+    if(!languageFields.next(field1) || !languageFields.next(field2))
+        return false;
+    lang1 = field1.to_string();
+    lang2 = field2.to_string();
+
+    // Check to see if the languages are equal (this is not allowed)
+    if(caseInsensitiveEquals(lang1, lang2))
         return false;
 
-    std::list<Connection>::iterator itr;
-    for(itr = connList.begin(); itr != connList.end(); itr++)
+    pos = (lineEnd == end) ? end : lineEnd + 1;
+
+    // Read the rest of the file, one connection per line
+    while(pos != end)
     {
+        lineEnd = findLineEnd(pos, end);
+
+        // Make sure there are at least two tokens; ignore any additional
+        FieldScanner fields(pos, lineEnd);
+        if(!fields.next(field1) || !fields.next(field2))
+            return false;
+
+        addPooledConnection(Connection(*wordPool, lang1, lang2,
+                                       field1, field2));
+        wordsLoaded++;
 
+        pos = (lineEnd == end) ? end : lineEnd + 1;
     }
 
-    dictFile.close();
+    lastLoad.wordsLoaded = wordsLoaded;
+    lastLoad.seconds = secondsSince(start);
+    return true;
+}
 
+/**
+ * Loads a dictionary saved in the compact format (see CompactDictionary).
+ * The words come back sorted by their first word.
+ * @param filename The location of the compact dictionary
+ * @return True if the load was successful, false otherwise
+ */
+bool MasterList::loadFromCompactFile(std::string filename)
+{
+    ptime start = microsec_clock::universal_time();
+    size_t sizeBefore = connections.size();
+
+    CompactDictionary dictionary;
+    if(!dictionary.loadFromFile(filename))
+        return false;
+
+    // Check to see if the languages are equal (this is not allowed)
+    if(caseInsensitiveEquals(dictionary.lang1, dictionary.lang2))
+        return false;
+
+    dictionary.expand(*this);
+
+    lastLoad.wordsLoaded = connections.size() - sizeBefore;
+    lastLoad.seconds = secondsSince(start);
     return true;
 }
+
+/**
+ * Saves a master list to a text file which loadFromFile and the other
+ * loaders can read back: the list name, the languages, and then one
+ * connection per line. The statistics of each connection follow its words,
+ * as in a profile; the dictionary loaders ignore them.
+ * @param filename The location of the text file to write
+ * @return True if the whole list was written, false otherwise
+ */
+bool MasterList::saveToFile(std::string filename)
+{
+    BufferedWriter dictFile;
+
+    // Check for failed file open
+    if(!dictFile.open(filename))
+        return false;
+
+    // The rows are in column order, so the languages must be too
+    string columnLang1, columnLang2;
+    getColumnLanguages(columnLang1, columnLang2);
+
+    dictFile.write(listName);
+    dictFile.put('\n');
+    dictFile.write(columnLang1);
+    dictFile.put('\t');
+    dictFile.write(columnLang2);
+    dictFile.put('\n');
+
+    connections.writeRows(dictFile);
+
+    return dictFile.close();
+}
+
+/**
+ * Saves the words of a master list in the compact format, which takes a
+ * fraction of the space of a text dictionary when many words share their
+ * beginnings. Statistics are not saved.
+ * @param filename The location of the file to write
+ * @return True if the whole list was written, false otherwise
+ */
+bool MasterList::saveToCompactFile(std::string filename)
+{
+    CompactDictionary dictionary;
+    dictionary.build(*this);
+
+    return dictionary.saveToFile(filename);
+}
@@ -2,22 +2,41 @@
 #define QUIZLIST_H
 
 #include "connection.hpp"
+#include "connectiontable.hpp"
 #include "languagepair.hpp"
+#include "wordpool.hpp"
 
-#include <list>
 #include <string>
 #include <cctype>
 #include <set>
+#include <vector>
 
 #include <iostream>
 #include <fstream>
 #include <boost/config.hpp>
 #include <boost/foreach.hpp>
-#include <boost/tokenizer.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
 #include <boost/algorithm/string.hpp>
 
 #include "exceptions.hpp"
 
+/**
+ * Timing information about the most recent load of a MasterList, so that
+ * the different loaders can be compared against each other.
+ */
+struct LoadStatistics
+{
+    //! Number of connections read from the file
+    unsigned long wordsLoaded;
+    //! Wall clock time the load took, in seconds
+    double seconds;
+
+    LoadStatistics();
+    double wordsPerSecond() const;
+};
+
 class QuizList
 {
 
@@ -27,39 +46,93 @@ public:
 
     std::string listName;
 
-    //! An ordered list of all the connections loaded into the quiz
-    std::list<Connection> connList;
-    //! The current position through the quiz
-    std::list<Connection>::iterator listItr;
+    //! All the connections loaded into the quiz, in order, one per row.
+    //! New connections should only be added through addConnection, which
+    //! keeps the lookup indices below in sync.
+    ConnectionTable connections;
+    //! The current position through the quiz, as a row of connections
+    size_t listPos;
+
+    //! Returned by findConnection when there is no such connection.
+    static const size_t npos = (size_t) -1;
 
     //! @todo An enumeration of the current order of the list (LEAST_KNOWN, etc)
 
+    //! Stores the words of every connection in the list. Lists belonging to
+    //! the same user profile share one pool.
+    boost::shared_ptr<WordPool> wordPool;
+
+protected:
+    //! A pair of word handles from wordPool, used as an index key.
+    typedef std::pair<const std::string*, const std::string*> WordPair;
+
+    //! The row of every connection, keyed on the exact words. Where a pair
+    //! of words occurs twice, the first row is kept.
+    boost::unordered_map<WordPair, size_t> exactIndex;
+    //! Index of every connection, keyed on the case-folded words.
+    boost::unordered_set<WordPair> foldedIndex;
+
+    //! The rows holding a word, keyed on the word's handle.
+    typedef boost::unordered_multimap<const std::string*, size_t> RowIndex;
+
+    //! The rows of every word in each column, so that a word's translations
+    //! can be found without scanning the list; exactly and case-folded.
+    RowIndex word1Rows;
+    RowIndex word2Rows;
+    RowIndex foldedWord1Rows;
+    RowIndex foldedWord2Rows;
+
+    void rebuildExactIndex(const std::vector<size_t> &order);
+    void sortByWords(bool byWord1);
+
 public:
     QuizList();
 
+    void addConnection(Connection conn);
+    void addPooledConnection(const Connection &conn);
+    Connection getConnection(size_t row);
+    void getColumnLanguages(std::string &first, std::string &second) const;
+    size_t findConnection(boost::string_ref word1, boost::string_ref word2);
+    void reorder(const std::vector<size_t> &order);
+
     void sortByLang1();
     void sortByLang2();
     void sortByLeastKnown();
     void sortByMostKnown();
-    //! Unimplemented until connection's last quizzed variable is implemented
     void sortByLastQuizzed();
     void sortByRecentlyQuizzed();
 
-    bool contains(Connection conn, bool caseSensitive);
+    bool contains(const Connection &conn, bool caseSensitive);
+    bool containsWords(const std::string &word1, const std::string &word2,
+                       bool caseSensitive);
+    void findTranslations(const std::string &word, bool fromWord1,
+                          bool caseSensitive,
+                          std::vector<const std::string*> &translations);
+
+    size_t bytesUsed() const;
 };
 
 class MasterList : public QuizList
 {
 
 public:
+    //! Statistics about the last call to one of the load functions.
+    LoadStatistics lastLoad;
+
     MasterList();
     MasterList(LanguagePair languages);
+    MasterList(LanguagePair languages, boost::shared_ptr<WordPool> pool);
     MasterList(MasterList* existing);
     void printContents();
     bool importDictionaryFromFile(std::string filename);
+    bool importDictionaryFromFile(std::string filename,
+                                  unsigned int numThreads);
 
     bool loadFromFile(std::string filename);
+    bool loadFromMappedFile(std::string filename);
+    bool loadFromCompactFile(std::string filename);
     bool saveToFile(std::string filename);
+    bool saveToCompactFile(std::string filename);
 };
 
 #endif // QUIZLIST_H
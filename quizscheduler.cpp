@@ -0,0 +1,189 @@
+/**
+ * @file quizscheduler.cpp
+ * @brief Decides which connection of a quiz should be asked next.
+ * @author Alex Zirbel
+ *
+ * A simple spaced-repetition scheduler. Every connection is due for review
+ * some time after it was last quizzed, and the better the user knows it, the
+ * longer that interval is. Connections are kept in an indexed binary heap
+ * ordered by due time, then by proficiency, then by their order in the list,
+ * so finding the next prompt and rescheduling a connection after it has been
+ * answered are both O(log n), however large the list is.
+ */
+
+#include "quizscheduler.hpp"
+
+using namespace std;
+
+QuizScheduler::QuizScheduler()
+{
+    table = NULL;
+}
+
+
+/**
+ * Schedules every connection in a table, replacing anything scheduled
+ * before. Only the statistics columns are read. The table must outlive the
+ * scheduler, or at least the next call to build, and must not be reordered
+ * in between.
+ * @param connections The connections to schedule
+ */
+void QuizScheduler::build(ConnectionTable &connections)
+{
+    table = &connections;
+
+    const vector<int> &proficiency = connections.proficiencyColumn();
+    const vector<time_t> &lastQuizzed = connections.lastQuizzedColumn();
+    size_t count = connections.size();
+
+    due.resize(count);
+    for(size_t i = 0; i < count; i++)
+        due[i] = dueTime(proficiency[i], lastQuizzed[i]);
+
+    heap.resize(count);
+    position.resize(count);
+    for(size_t i = 0; i < count; i++)
+        place(i, i);
+
+    // Heapify bottom up, which is O(n)
+    for(size_t i = heap.size() / 2; i > 0; i--)
+        siftDown(i - 1);
+}
+
+
+/**
+ * Whether there is anything to schedule at all.
+ */
+bool QuizScheduler::empty()
+{
+    return heap.empty();
+}
+
+
+/**
+ * The number of connections being scheduled.
+ */
+size_t QuizScheduler::size()
+{
+    return heap.size();
+}
+
+
+/**
+ * Returns the handle of the connection which should be asked next, which is
+ * its row in the table. The scheduler must not be empty.
+ */
+size_t QuizScheduler::top()
+{
+    return heap[0];
+}
+
+
+/**
+ * Updates a connection's statistics after the user has answered it and moves
+ * it to its new place in the schedule.
+ * @param handle The handle of the connection which was asked
+ * @param correct Whether the user answered correctly
+ * @param when The time the answer was given
+ */
+void QuizScheduler::recordAnswer(size_t handle, bool correct, time_t when)
+{
+    int proficiency = table->getUserProficiency(handle);
+
+    if(correct)
+        proficiency = min(proficiency + PROFICIENCY_GAIN, 100);
+    else
+        proficiency = max(proficiency - PROFICIENCY_LOSS, 0);
+
+    table->setUserProficiency(handle, proficiency);
+    table->setLastQuizzed(handle, when);
+
+    due[handle] = dueTime(proficiency, when);
+
+    // The connection may have to move either way in the heap
+    siftUp(position[handle]);
+    siftDown(position[handle]);
+}
+
+
+/**
+ * The time a connection is next due for review: the better it is known, the
+ * longer after its last quiz.
+ */
+time_t QuizScheduler::dueTime(int proficiency, time_t lastQuizzed)
+{
+    time_t interval = proficiency;
+
+    return lastQuizzed + interval * interval * SCHEDULE_INTERVAL_SCALE;
+}
+
+
+/**
+ * Whether handle a should be asked before handle b.
+ */
+bool QuizScheduler::before(size_t a, size_t b)
+{
+    if(due[a] != due[b])
+        return due[a] < due[b];
+
+    int proficiencyA = table->getUserProficiency(a);
+    int proficiencyB = table->getUserProficiency(b);
+    if(proficiencyA != proficiencyB)
+        return proficiencyA < proficiencyB;
+
+    // Otherwise keep the order of the list
+    return a < b;
+}
+
+
+/**
+ * Puts a handle at a position in the heap and records where it is.
+ */
+void QuizScheduler::place(size_t index, size_t handle)
+{
+    heap[index] = handle;
+    position[handle] = index;
+}
+
+
+void QuizScheduler::siftUp(size_t index)
+{
+    size_t handle = heap[index];
+
+    while(index > 0)
+    {
+        size_t parent = (index - 1) / 2;
+        if(!before(handle, heap[parent]))
+            break;
+
+        place(index, heap[parent]);
+        index = parent;
+    }
+
+    place(index, handle);
+}
+
+
+void QuizScheduler::siftDown(size_t index)
+{
+    size_t handle = heap[index];
+    size_t count = heap.size();
+
+    while(true)
+    {
+        size_t child = 2 * index + 1;
+        if(child >= count)
+            break;
+
+        if(child + 1 < count && before(heap[child + 1], heap[child]))
+            child++;
+
+        if(!before(heap[child], handle))
+            break;
+
+        place(index, heap[child]);
+        index = child;
+    }
+
+    place(index, handle);
+}
@@ -0,0 +1,51 @@
+/**
+ * @file quizscheduler.hpp
+ * @brief Header definitions for the QuizScheduler class.
+ * @author Alex Zirbel
+ */
+
+#ifndef QUIZSCHEDULER_H
+#define QUIZSCHEDULER_H
+
+#include <vector>
+#include <ctime>
+
+#include "connectiontable.hpp"
+
+//! Seconds between reviews grow with the square of proficiency, times this.
+#define SCHEDULE_INTERVAL_SCALE 6
+//! Proficiency gained for a correct answer.
+#define PROFICIENCY_GAIN 10
+//! Proficiency lost for a wrong answer.
+#define PROFICIENCY_LOSS 20
+
+class QuizScheduler
+{
+//! The connections being scheduled. A connection's handle is its row here.
+ConnectionTable *table;
+//! The time each connection is next due, cached from its statistics.
+std::vector<time_t> due;
+//! A binary min-heap of handles, ordered by compare().
+std::vector<size_t> heap;
+//! Where each handle currently sits in the heap.
+std::vector<size_t> position;
+
+public:
+    QuizScheduler();
+
+    void build(ConnectionTable &connections);
+    bool empty();
+    size_t size();
+    size_t top();
+    void recordAnswer(size_t handle, bool correct, time_t when);
+
+    static time_t dueTime(int proficiency, time_t lastQuizzed);
+
+private:
+    bool before(size_t a, size_t b);
+    void place(size_t index, size_t handle);
+    void siftUp(size_t index);
+    void siftDown(size_t index);
+};
+
+#endif // QUIZSCHEDULER_H
@@ -0,0 +1,1091 @@
+/**
+ * @file quizserver.cpp
+ * @brief Serves quiz sessions for many learners from one process.
+ * @author Alex Zirbel
+ *
+ * A headless front end to the quiz engine for machines shared by many
+ * learners. Instead of every learner running the whole program with their
+ * own copy of every dictionary, one server loads the dictionaries once and
+ * keeps the profiles of everyone logged in, and thin clients connect to it
+ * over a Unix domain socket.
+ *
+ * Each connection is a session. The main thread waits for requests on every
+ * idle session at once; a session with something to read is handed to one
+ * of a fixed pool of worker threads, which answers every complete request
+ * the session has sent and then hands it back. Many more sessions than
+ * threads can be open, and a session never ties up a thread while it is
+ * idle. Sessions are never waited on to write either: replies a client is
+ * slow to take are kept on the session, which is not read from again until
+ * they have been sent.
+ *
+ * Dictionaries given on the command line are shared by every session for
+ * lookups and completions. They are held as CompactDictionary objects, which
+ * are never changed after loading and so need no locking; a dictionary saved
+ * in the compact format is mapped rather than read. Profiles are loaded
+ * through ProfileManager and are shared by every session of the same learner,
+ * with a lock per learner, and each answer is recorded in the learner's
+ * journal as in the GUI. What is being quizzed and the score belong to the
+ * session.
+ *
+ * Requests and replies are single lines of tab-separated fields. Every reply
+ * starts with OK or ERR; the fields after ERR describe the problem. Quizzes
+ * ask from a list's first language, as LANGUAGES lists it, unless reversed.
+ *
+ *   LOGIN <username>                  Log in as a learner with a profile
+ *   LOGOUT
+ *   LANGUAGES                         OK, then lang1 and lang2 of each list
+ *   START <lang1> <lang2> [reverse]   Start quizzing one of the lists
+ *   SET case <on|off>                 Whether capitalization matters
+ *   SET typos <count>                 How many typos to forgive
+ *   NEXT                              OK and the next prompt, or OK DONE
+ *   ANSWER <answer>                   OK, correct or wrong, the answer; the
+ *                                     prompt must be asked for with NEXT
+ *   SCORE                             OK, number right, number wrong
+ *   DICTIONARIES                      OK, then the name, lang1 and lang2
+ *                                     of each dictionary
+ *   LOOKUP <dictionary> <word>        OK and each translation of a lang1 word
+ *   COMPLETE <dictionary> <prefix>    OK and lang1 words starting with prefix
+ *   QUIT
+ *
+ * Usage: quizserver [-s socket] [-j threads] [dictionary ...]
+ *   -s socket   Where to listen (default: quizserver.sock in WORDQUIZ_DIR)
+ *   -j threads  Serve requests on this many threads (default: one per core)
+ *   dictionary  A text or compact dictionary to share with every session
+ */
+
+#include <iostream>
+#include <map>
+#include <deque>
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <clocale>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "answerjournal.hpp"
+#include "compactdictionary.hpp"
+#include "fieldscanner.hpp"
+#include "languageregistry.hpp"
+#include "profilemanager.hpp"
+#include "quizlist.hpp"
+#include "util_global.hpp"
+#include "vocabquiz.hpp"
+#include "wordcompleter.hpp"
+
+using namespace std;
+using boost::string_ref;
+
+//! Where the server listens unless told otherwise.
+#define DEFAULT_SOCKET_PATH WORDQUIZ_DIR "quizserver.sock"
+
+//! How much is read from a session at a time.
+#define READ_CHUNK_SIZE 4096
+
+//! Sessions which send a longer line than this are disconnected.
+#define MAX_REQUEST_LENGTH 65536
+
+//! How many connections may wait to be accepted.
+#define LISTEN_BACKLOG 64
+
+/**
+ * A learner with at least one session logged in. The profile and journal
+ * are shared by all of the learner's sessions and may only be used while
+ * holding lock.
+ *
+ * The profile is loaded and saved without holding the server's lock on the
+ * learners, so a learner is listed while loading and closing as well; other
+ * sessions logging in as the learner wait for it to be ready, or to be gone.
+ */
+struct Learner
+{
+    enum State { LOADING, READY, CLOSING };
+
+    boost::mutex lock;
+    UserProfile *profile;
+    AnswerJournal *journal;
+    //! How many sessions are logged in as this learner.
+    int numSessions;
+    //! Guarded by the server's lock on the learners.
+    State state;
+};
+
+/**
+ * One client connection.
+ */
+struct Session
+{
+    int fd;
+    //! Bytes received which do not yet make a complete line.
+    string input;
+    //! Replies which the client has not yet taken.
+    string output;
+
+    string username;
+    boost::shared_ptr<Learner> learner;
+    //! The quiz of one of the learner's lists, if one has been started.
+    boost::scoped_ptr<FillInVocabQuiz> quiz;
+
+    //! Set while a worker is serving the session.
+    bool busy;
+    //! Set once the session should be disconnected.
+    bool closed;
+};
+
+//! The write end of the pipe which wakes the main thread, for the signal
+//! handler.
+static int wakeFd = -1;
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int)
+{
+    stopRequested = 1;
+
+    char byte = 0;
+    if(write(wakeFd, &byte, 1) < 0)
+    {
+        // Nothing can be done about it in a signal handler
+    }
+}
+
+/**
+ * Joins reply fields into one line.
+ */
+static string reply(const vector<string> &fields)
+{
+    string line = "OK";
+
+    for(size_t i = 0; i < fields.size(); i++)
+    {
+        line += '\t';
+        line += fields[i];
+    }
+
+    return line + "\n";
+}
+
+static string reply(const string &field)
+{
+    return reply(vector<string>(1, field));
+}
+
+static string errorReply(const string &message)
+{
+    return "ERR\t" + message + "\n";
+}
+
+static string toString(int value)
+{
+    char digits[16];
+    sprintf(digits, "%d", value);
+    return digits;
+}
+
+/**
+ * Sends as much of a session's pending replies as the client will take
+ * without waiting, keeping the rest for when it can take more.
+ * @return False if the client has gone away.
+ */
+static bool sendOutput(Session *session)
+{
+    size_t sent = 0;
+
+    while(sent < session->output.size())
+    {
+        ssize_t count = send(session->fd, session->output.data() + sent,
+                             session->output.size() - sent, MSG_NOSIGNAL);
+        if(count < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            if(errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            return false;
+        }
+
+        sent += count;
+    }
+
+    session->output.erase(0, sent);
+    return true;
+}
+
+class QuizServer
+{
+int listenFd;
+//! Written to by workers and the signal handler to wake the main thread.
+int wakePipe[2];
+string socketPath;
+
+//! The shared dictionaries by name. Not changed once the server starts.
+map<string, boost::shared_ptr<CompactDictionary> > dictionaries;
+
+//! Every open session by its descriptor. Only the main thread adds and
+//! removes sessions. busy is guarded by queueLock; while it is set, the rest
+//! of the session belongs to the worker serving it.
+map<int, Session*> sessions;
+
+boost::mutex queueLock;
+boost::condition_variable queueReady;
+//! Sessions with something to read, waiting for a worker.
+deque<Session*> ready;
+bool stopping;
+
+boost::thread_group workers;
+
+boost::mutex learnersLock;
+//! Signalled when a learner finishes loading or closing.
+boost::condition_variable learnersChanged;
+map<string, boost::shared_ptr<Learner> > learners;
+
+public:
+    QuizServer();
+    ~QuizServer();
+
+    bool addDictionary(const string &filename);
+    bool listen(const string &path);
+    void run(unsigned int numThreads);
+
+private:
+    friend struct WorkerTask;
+
+    void acceptSession();
+    void workerLoop();
+    void serve(Session *session);
+    string handleRequest(Session *session, const string &line);
+    string dispatchRequest(Session *session, const string &line);
+
+    string login(Session *session, string_ref username);
+    void logout(Session *session);
+    string startQuiz(Session *session, FieldScanner &fields);
+    string setOption(Session *session, FieldScanner &fields);
+    string nextPrompt(Session *session);
+    string checkAnswer(Session *session, string_ref answer);
+    string lookup(FieldScanner &fields, bool complete);
+};
+
+
+/**
+ * Runs one of the server's worker threads.
+ */
+struct WorkerTask
+{
+    QuizServer *server;
+
+    void operator()()
+    {
+        server->workerLoop();
+    }
+};
+
+
+QuizServer::QuizServer()
+{
+    listenFd = -1;
+    wakePipe[0] = wakePipe[1] = -1;
+    stopping = false;
+}
+
+
+/**
+ * Logs out and disconnects every session still open, and removes the
+ * socket so that the next server can listen on it.
+ */
+QuizServer::~QuizServer()
+{
+    map<int, Session*>::iterator itr;
+    for(itr = sessions.begin(); itr != sessions.end(); itr++)
+    {
+        logout(itr->second);
+        close(itr->first);
+        delete itr->second;
+    }
+
+    if(listenFd != -1)
+    {
+        close(listenFd);
+        unlink(socketPath.c_str());
+    }
+    if(wakePipe[0] != -1)
+    {
+        close(wakePipe[0]);
+        close(wakePipe[1]);
+    }
+}
+
+
+/**
+ * Loads a dictionary to share with every session. Compact dictionaries are
+ * mapped; text dictionaries are loaded and then compacted. Dictionaries are
+ * known by their list names, or by their filenames where the names clash.
+ * @param filename A compact or text dictionary
+ * @return False if the file could not be loaded.
+ */
+bool QuizServer::addDictionary(const string &filename)
+{
+    boost::shared_ptr<CompactDictionary> dictionary(new CompactDictionary);
+
+    if(!dictionary->loadFromFile(filename))
+    {
+        MasterList list;
+        if(!list.loadFromMappedFile(filename))
+            return false;
+
+        dictionary->build(list);
+    }
+
+    string name = dictionary->listName;
+    if(name.empty() || dictionaries.count(name) != 0)
+        name = filename;
+    dictionaries[name] = dictionary;
+
+    return true;
+}
+
+
+/**
+ * Starts listening on a Unix domain socket. A socket left behind by a
+ * server which did not shut down cleanly is replaced.
+ * @return False if the socket could not be created.
+ */
+bool QuizServer::listen(const string &path)
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if(path.size() >= sizeof(address.sun_path))
+        return false;
+    strcpy(address.sun_path, path.c_str());
+
+    if(pipe(wakePipe) != 0)
+        return false;
+    fcntl(wakePipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(wakePipe[1], F_SETFL, O_NONBLOCK);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listenFd == -1)
+        return false;
+
+    unlink(path.c_str());
+    if(bind(listenFd, (sockaddr*) &address, sizeof(address)) != 0 ||
+       ::listen(listenFd, LISTEN_BACKLOG) != 0)
+    {
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    socketPath = path;
+    return true;
+}
+
+
+/**
+ * Serves sessions until the process is asked to stop.
+ * @param numThreads How many worker threads answer requests
+ */
+void QuizServer::run(unsigned int numThreads)
+{
+    wakeFd = wakePipe[1];
+    signal(SIGINT, requestStop);
+    signal(SIGTERM, requestStop);
+    signal(SIGPIPE, SIG_IGN);
+
+    WorkerTask task;
+    task.server = this;
+    for(unsigned int i = 0; i < numThreads; i++)
+        workers.create_thread(task);
+
+    vector<pollfd> polled;
+    vector<Session*> polledSessions;
+
+    while(!stopRequested)
+    {
+        polled.clear();
+        polledSessions.clear();
+
+        pollfd listenPoll = { listenFd, POLLIN, 0 };
+        pollfd wakePoll = { wakePipe[0], POLLIN, 0 };
+        polled.push_back(listenPoll);
+        polled.push_back(wakePoll);
+
+        // Drop the sessions which have finished, and wait on the idle ones
+        {
+            boost::mutex::scoped_lock guard(queueLock);
+
+            map<int, Session*>::iterator itr = sessions.begin();
+            while(itr != sessions.end())
+            {
+                Session *session = itr->second;
+
+                if(session->busy)
+                {
+                    itr++;
+                }
+                else if(session->closed)
+                {
+                    close(session->fd);
+                    delete session;
+                    sessions.erase(itr++);
+                }
+                else
+                {
+                    // Read no more requests until the replies have been sent
+                    short events = session->output.empty() ? POLLIN : POLLOUT;
+                    pollfd sessionPoll = { session->fd, events, 0 };
+                    polled.push_back(sessionPoll);
+                    polledSessions.push_back(session);
+                    itr++;
+                }
+            }
+        }
+
+        if(poll(&polled[0], polled.size(), -1) < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            break;
+        }
+
+        if(polled[1].revents != 0)
+        {
+            char drain[64];
+            while(read(wakePipe[0], drain, sizeof(drain)) > 0)
+                ;
+        }
+
+        if(polled[0].revents & POLLIN)
+            acceptSession();
+
+        boost::mutex::scoped_lock guard(queueLock);
+        for(size_t i = 0; i < polledSessions.size(); i++)
+        {
+            if(polled[i + 2].revents == 0)
+                continue;
+
+            polledSessions[i]->busy = true;
+            ready.push_back(polledSessions[i]);
+            queueReady.notify_one();
+        }
+    }
+
+    {
+        boost::mutex::scoped_lock guard(queueLock);
+        stopping = true;
+    }
+    queueReady.notify_all();
+    workers.join_all();
+}
+
+
+void QuizServer::acceptSession()
+{
+    int fd = accept(listenFd, NULL, NULL);
+    if(fd == -1)
+        return;
+
+    // Workers must never wait on a client which is slow to read or write
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    Session *session = new Session;
+    session->fd = fd;
+    session->busy = false;
+    session->closed = false;
+
+    boost::mutex::scoped_lock guard(queueLock);
+    sessions[fd] = session;
+}
+
+
+/**
+ * Serves sessions handed over by the main thread until the server stops.
+ */
+void QuizServer::workerLoop()
+{
+    while(true)
+    {
+        Session *session;
+
+        {
+            boost::mutex::scoped_lock guard(queueLock);
+            while(ready.empty() && !stopping)
+                queueReady.wait(guard);
+
+            if(stopping)
+                return;
+
+            session = ready.front();
+            ready.pop_front();
+        }
+
+        serve(session);
+
+        {
+            boost::mutex::scoped_lock guard(queueLock);
+            session->busy = false;
+        }
+
+        // The main thread must start waiting on the session again
+        char byte = 0;
+        if(write(wakePipe[1], &byte, 1) < 0)
+        {
+            // The pipe is full, so the main thread will wake anyway
+        }
+    }
+}
+
+
+/**
+ * Sends a session the replies it is waiting for, or if there are none, reads
+ * what it has sent and answers every complete request in it. The session is
+ * only read once, since the main thread only knows that there is something
+ * to read.
+ */
+void QuizServer::serve(Session *session)
+{
+    if(!session->output.empty())
+    {
+        if(!sendOutput(session))
+        {
+            logout(session);
+            session->closed = true;
+        }
+        return;
+    }
+
+    char buffer[READ_CHUNK_SIZE];
+    ssize_t count = recv(session->fd, buffer, sizeof(buffer), 0);
+
+    if(count == 0 || (count < 0 && errno != EINTR && errno != EAGAIN))
+    {
+        logout(session);
+        session->closed = true;
+        return;
+    }
+    if(count < 0)
+        return;
+
+    session->input.append(buffer, count);
+
+    size_t lineStart = 0;
+    size_t lineEnd;
+    while(!session->closed &&
+          (lineEnd = session->input.find('\n', lineStart)) != string::npos)
+    {
+        string line = session->input.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        // Clients which end their lines with \r\n are welcome too
+        if(!line.empty() && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
+
+        session->output += handleRequest(session, line);
+    }
+    session->input.erase(0, lineStart);
+
+    if(session->input.size() > MAX_REQUEST_LENGTH)
+    {
+        session->output += errorReply("Request too long.");
+        session->closed = true;
+    }
+
+    // A session being disconnected gets what the client will take of its
+    // last replies, but is not kept open for the rest
+    if(!sendOutput(session))
+        session->closed = true;
+
+    if(session->closed)
+        logout(session);
+}
+
+
+/**
+ * Answers one request. Whatever goes wrong answering it is only reported to
+ * the session which sent it, so that no request can stop the server.
+ * @return The reply, ending with a newline.
+ */
+string QuizServer::handleRequest(Session *session, const string &line)
+{
+    try
+    {
+        return dispatchRequest(session, line);
+    }
+    catch(exception *e)
+    {
+        string message = e->what();
+        delete e;
+        return errorReply(message);
+    }
+    catch(exception &e)
+    {
+        return errorReply(e.what());
+    }
+    catch(...)
+    {
+        return errorReply("The request failed.");
+    }
+}
+
+
+/**
+ * Answers one request by passing it to the function which handles it.
+ * @return The reply, ending with a newline.
+ */
+string QuizServer::dispatchRequest(Session *session, const string &line)
+{
+    FieldScanner fields(line);
+    string_ref command;
+
+    if(!fields.next(command))
+        return errorReply("Empty request.");
+
+    if(command == "QUIT")
+    {
+        session->closed = true;
+        return reply(vector<string>());
+    }
+    if(command == "DICTIONARIES")
+    {
+        vector<string> fields;
+        map<string, boost::shared_ptr<CompactDictionary> >::iterator itr;
+        for(itr = dictionaries.begin(); itr != dictionaries.end(); itr++)
+        {
+            fields.push_back(itr->first);
+            fields.push_back(itr->second->lang1);
+            fields.push_back(itr->second->lang2);
+        }
+        return reply(fields);
+    }
+    if(command == "LOOKUP")
+        return lookup(fields, false);
+    if(command == "COMPLETE")
+        return lookup(fields, true);
+
+    if(command == "LOGIN")
+    {
+        string_ref username;
+        if(!fields.next(username))
+            return errorReply("LOGIN needs a username.");
+        return login(session, username);
+    }
+
+    // Everything else needs a learner
+    if(!session->learner)
+        return errorReply("Not logged in.");
+
+    boost::mutex::scoped_lock guard(session->learner->lock);
+
+    if(command == "LOGOUT")
+    {
+        guard.unlock();
+        logout(session);
+        return reply(vector<string>());
+    }
+    if(command == "LANGUAGES")
+    {
+        vector<LanguagePair> pairs = session->learner->profile->getLanguagePairs();
+        vector<string> languages;
+        for(size_t i = 0; i < pairs.size(); i++)
+        {
+            languages.push_back(pairs[i].lang1);
+            languages.push_back(pairs[i].lang2);
+        }
+        return reply(languages);
+    }
+    if(command == "START")
+        return startQuiz(session, fields);
+    if(command == "SET")
+        return setOption(session, fields);
+    if(command == "NEXT")
+        return nextPrompt(session);
+    if(command == "ANSWER")
+    {
+        // A missing answer is graded as an empty one
+        string_ref answer;
+        fields.next(answer);
+        return checkAnswer(session, answer);
+    }
+    if(command == "SCORE")
+    {
+        if(!session->quiz)
+            return errorReply("No quiz started.");
+
+        vector<string> score;
+        score.push_back(toString(session->quiz->getNumRight()));
+        score.push_back(toString(session->quiz->getNumWrong()));
+        return reply(score);
+    }
+
+    return errorReply("Unknown request " + command.to_string() + ".");
+}
+
+
+/**
+ * Logs a session in, loading the learner's profile unless another session
+ * already has. Only the session which lists the learner loads the profile;
+ * other sessions logging in as the same learner meanwhile wait for it.
+ */
+string QuizServer::login(Session *session, string_ref username)
+{
+    logout(session);
+
+    string name = username.to_string();
+    boost::shared_ptr<Learner> learner;
+
+    {
+        boost::mutex::scoped_lock guard(learnersLock);
+
+        while(!learner)
+        {
+            map<string, boost::shared_ptr<Learner> >::iterator itr =
+                    learners.find(name);
+
+            if(itr == learners.end())
+            {
+                learner.reset(new Learner);
+                learner->profile = NULL;
+                learner->journal = NULL;
+                learner->numSessions = 1;
+                learner->state = Learner::LOADING;
+                learners[name] = learner;
+            }
+            else if(itr->second->state == Learner::READY)
+            {
+                learner = itr->second;
+                learner->numSessions++;
+            }
+            else
+            {
+                learnersChanged.wait(guard);
+            }
+        }
+
+        if(learner->state == Learner::READY)
+        {
+            session->username = name;
+            session->learner = learner;
+            return reply(learner->profile->getFullName());
+        }
+    }
+
+    // Load the profile without holding up logins of other learners
+    ProfileManager profileManager;
+    string error;
+
+    try
+    {
+        learner->profile = profileManager.loadProfile(name);
+
+        if(!learner->profile->isValid())
+        {
+            delete learner->profile;
+            learner->profile = NULL;
+            error = "Invalid profile.";
+        }
+        else
+            learner->journal = profileManager.openJournal(learner->profile);
+    }
+    catch(NoSuchProfileException &)
+    {
+        error = "No such profile.";
+    }
+    catch(InvalidUsernameException *e)
+    {
+        delete e;
+        error = "Invalid username.";
+    }
+    catch(InvalidUserProfileException *e)
+    {
+        delete e;
+        error = "Invalid profile.";
+    }
+    catch(exception *e)
+    {
+        delete e;
+        error = "The profile could not be loaded.";
+    }
+    catch(...)
+    {
+        // Other sessions are waiting for the learner to load
+        error = "The profile could not be loaded.";
+    }
+
+    boost::mutex::scoped_lock guard(learnersLock);
+    learnersChanged.notify_all();
+
+    if(!error.empty())
+    {
+        learners.erase(name);
+        return errorReply(error);
+    }
+
+    learner->state = Learner::READY;
+    session->username = name;
+    session->learner = learner;
+
+    return reply(learner->profile->getFullName());
+}
+
+
+/**
+ * Ends a session's quiz and logs it out. The last session of a learner to
+ * log out closes the journal, which holds every answer, and frees the
+ * profile, leaving a copy in the profile cache for the next login.
+ */
+void QuizServer::logout(Session *session)
+{
+    if(!session->learner)
+        return;
+
+    boost::shared_ptr<Learner> learner = session->learner;
+    {
+        boost::mutex::scoped_lock guard(learner->lock);
+        session->quiz.reset();
+    }
+    session->learner.reset();
+
+    boost::mutex::scoped_lock guard(learnersLock);
+    if(--learner->numSessions > 0)
+        return;
+
+    // Save the profile without holding up logins of other learners
+    learner->state = Learner::CLOSING;
+    guard.unlock();
+
+    ProfileManager profileManager;
+    profileManager.closeJournal(learner->journal, learner->profile);
+    delete learner->profile;
+
+    guard.lock();
+    learners.erase(session->username);
+    learnersChanged.notify_all();
+}
+
+
+string QuizServer::startQuiz(Session *session, FieldScanner &fields)
+{
+    string_ref lang1, lang2, direction;
+
+    if(!fields.next(lang1) || !fields.next(lang2))
+        return errorReply("START needs two languages.");
+
+    // Names no profile or dictionary has used are not worth registering
+    unsigned int id;
+    if(!LanguageRegistry::instance().find(lang1, id) ||
+       !LanguageRegistry::instance().find(lang2, id))
+        return errorReply("Unknown language.");
+
+    MasterList *list;
+    try
+    {
+        LanguagePair languages(lang1.to_string(), lang2.to_string(), 1);
+        list = session->learner->profile->getMasterListForLanguages(languages);
+    }
+    catch(InvalidLanguageException *e)
+    {
+        delete e;
+        return errorReply("The languages must differ.");
+    }
+    catch(InvalidUserProfileException *e)
+    {
+        delete e;
+        return errorReply("Invalid profile.");
+    }
+
+    if(list == NULL)
+        return errorReply("No list for those languages.");
+
+    FillInVocabQuiz *quiz = new FillInVocabQuiz(list);
+    quiz->setJournal(session->learner->journal);
+    if(session->quiz)
+    {
+        quiz->setCaseSensitive(session->quiz->getCaseSensitive());
+        quiz->setMaxTypos(session->quiz->getMaxTypos());
+    }
+
+    if(fields.next(direction) && direction == "reverse")
+        quiz->setDirection(REVERSE);
+
+    session->quiz.reset(quiz);
+
+    return reply(vector<string>());
+}
+
+
+string QuizServer::setOption(Session *session, FieldScanner &fields)
+{
+    string_ref option, value;
+
+    if(!session->quiz)
+        return errorReply("No quiz started.");
+    if(!fields.next(option) || !fields.next(value))
+        return errorReply("SET needs an option and a value.");
+
+    int typos;
+
+    if(option == "case")
+        session->quiz->setCaseSensitive(value == "on");
+    else if(option == "typos" && parseInt(value, typos) && typos >= 0)
+        session->quiz->setMaxTypos(typos);
+    else
+        return errorReply("Unknown option " + option.to_string() + ".");
+
+    return reply(vector<string>());
+}
+
+
+string QuizServer::nextPrompt(Session *session)
+{
+    if(!session->quiz)
+        return errorReply("No quiz started.");
+
+    string prompt = session->quiz->nextPrompt();
+    if(prompt.empty())
+        return reply("DONE");
+
+    return reply(prompt);
+}
+
+
+string QuizServer::checkAnswer(Session *session, string_ref answer)
+{
+    if(!session->quiz)
+        return errorReply("No quiz started.");
+    if(!session->quiz->hasPrompt())
+        return errorReply("No prompt.");
+
+    // Checking the answer finishes with the prompt, so look up its answer first
+    string correctAnswer = session->quiz->getCorrectAnswer();
+    bool correct = session->quiz->checkAnswer(answer.to_string());
+
+    vector<string> result;
+    result.push_back(correct ? "correct" : "wrong");
+    result.push_back(correctAnswer);
+    return reply(result);
+}
+
+
+/**
+ * Looks a word up in a shared dictionary, or completes a prefix.
+ * @param complete True to list words starting with the prefix given, false
+ *  to list the translations of the word given.
+ */
+string QuizServer::lookup(FieldScanner &fields, bool complete)
+{
+    string_ref name, word;
+
+    if(!fields.next(name) || !fields.next(word))
+        return errorReply("Which dictionary and word?");
+
+    map<string, boost::shared_ptr<CompactDictionary> >::iterator itr =
+            dictionaries.find(name.to_string());
+    if(itr == dictionaries.end())
+        return errorReply("No such dictionary.");
+
+    vector<string> words;
+    if(complete)
+    {
+        const CompactDictionary &dictionary = *itr->second;
+        size_t first = dictionary.lowerBound(word);
+        bool more = true;
+
+        // Entries with several translations repeat their first word, so
+        // read on until there are enough different words
+        while(more && words.size() < DEFAULT_MAX_COMPLETIONS)
+        {
+            vector<DictionaryEntry> entries;
+            size_t count = dictionary.getEntries(first, DEFAULT_MAX_COMPLETIONS,
+                                                 entries);
+            first += count;
+            more = (count != 0);
+
+            for(size_t i = 0; more && i < count; i++)
+            {
+                if(!string_ref(entries[i].word1).starts_with(word))
+                    more = false;
+                else if(words.empty() || words.back() != entries[i].word1)
+                    words.push_back(entries[i].word1);
+            }
+        }
+        if(words.size() > DEFAULT_MAX_COMPLETIONS)
+            words.resize(DEFAULT_MAX_COMPLETIONS);
+    }
+    else
+        itr->second->findTranslations(word, words);
+
+    return reply(words);
+}
+
+
+static void printUsage()
+{
+    cerr << "Usage: quizserver [-s socket] [-j threads] [dictionary ...]"
+         << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    string socketPath = DEFAULT_SOCKET_PATH;
+    unsigned int numThreads = boost::thread::hardware_concurrency();
+    vector<string> files;
+
+    // Case insensitive grading folds non-ASCII letters in the user's locale
+    setlocale(LC_CTYPE, "");
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            socketPath = argv[++i];
+        else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            numThreads = atoi(argv[++i]);
+        else if(argv[i][0] == '-')
+        {
+            printUsage();
+            return 1;
+        }
+        else
+            files.push_back(argv[i]);
+    }
+
+    if(numThreads == 0)
+        numThreads = 1;
+
+    QuizServer server;
+
+    for(size_t i = 0; i < files.size(); i++)
+    {
+        if(!server.addDictionary(files[i]))
+        {
+            cerr << "Unable to load dictionary " << files[i] << "." << endl;
+            return 1;
+        }
+    }
+
+    if(!server.listen(socketPath))
+    {
+        cerr << "Unable to listen on " << socketPath << "." << endl;
+        return 1;
+    }
+
+    cerr << "Serving " << files.size() << " dictionaries on " << socketPath
+         << " with " << numThreads << " threads." << endl;
+
+    server.run(numThreads);
+
+    return 0;
+}
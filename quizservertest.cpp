@@ -0,0 +1,280 @@
+/**
+ * @file quizservertest.cpp
+ * @brief Checks that the quiz server refuses requests made out of order.
+ * @author Alex Zirbel
+ *
+ * Starts a quiz server on a socket of its own, logs in as a throwaway
+ * learner and sends it requests a misbehaving client might send, such as an
+ * ANSWER with no prompt waiting for it. Each check is printed with whether
+ * it passed, and the exit status is 1 if any failed.
+ *
+ * The learners' profiles are written to the profiles directory before the
+ * server starts and removed, along with their journals, afterwards. One of
+ * them is corrupt, and logging in as it must fail without harming anyone
+ * else's session.
+ *
+ * Usage: quizservertest <quizserver>
+ *   quizserver  The server program to test
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "util_global.hpp"
+
+using namespace std;
+
+#define TEST_USERNAME "quizservertest"
+#define TEST_PROFILE WORDQUIZ_DIR "profiles/" TEST_USERNAME
+#define CORRUPT_USERNAME "quizservertestcorrupt"
+#define CORRUPT_PROFILE WORDQUIZ_DIR "profiles/" CORRUPT_USERNAME
+
+//! How long to wait for the server to start listening, in tenths of a second.
+#define CONNECT_ATTEMPTS 50
+
+static int numFailed = 0;
+
+/**
+ * Prints the outcome of one check and counts it if it failed.
+ */
+static void check(const string &description, const string &got,
+                  const string &expected)
+{
+    if(got == expected)
+    {
+        cout << "PASS  " << description << endl;
+        return;
+    }
+
+    cout << "FAIL  " << description << ": expected \"" << expected
+         << "\", got \"" << got << "\"" << endl;
+    numFailed++;
+}
+
+/**
+ * Writes a profile with one list to quiz from and one empty list, and a
+ * profile whose binary file is garbage.
+ */
+static bool writeProfiles()
+{
+    ofstream file((TEST_PROFILE ".txt"));
+    if(!file.is_open())
+        return false;
+
+    file << TEST_USERNAME "\nQuiz Server Test\n"
+         << "---\nEnglish\tGerman\t1\ndog\tHund\t40\t0\n"
+         << "---\nEnglish\tFrench\t1\n";
+    file.close();
+
+    remove(TEST_PROFILE ".wqp");
+    remove(TEST_PROFILE ".wqj");
+
+    ofstream corruptFile((CORRUPT_PROFILE ".txt"));
+    corruptFile << CORRUPT_USERNAME "\nCorrupt\n"
+                << "---\nEnglish\tGerman\t1\ncat\tKatze\t40\t0\n";
+    corruptFile.close();
+
+    ofstream garbage((CORRUPT_PROFILE ".wqp"));
+    garbage << "WQPF this is not a profile";
+    garbage.close();
+
+    remove(CORRUPT_PROFILE ".wqj");
+    return !file.fail() && !corruptFile.fail() && !garbage.fail();
+}
+
+static void removeProfiles()
+{
+    remove(TEST_PROFILE ".txt");
+    remove(TEST_PROFILE ".wqp");
+    remove(TEST_PROFILE ".wqj");
+    remove(CORRUPT_PROFILE ".txt");
+    remove(CORRUPT_PROFILE ".wqp");
+    remove(CORRUPT_PROFILE ".wqj");
+}
+
+/**
+ * Counts the answers recorded in the learner's journal.
+ */
+static int countJournalRecords()
+{
+    ifstream file((TEST_PROFILE ".wqj"));
+    int count = 0;
+    string line;
+    while(getline(file, line))
+        count++;
+    return count;
+}
+
+/**
+ * Connects to the server, waiting for it to start listening.
+ * @return The connected socket, or -1 if the server never listened.
+ */
+static int connectToServer(const string &path)
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    for(int attempt = 0; attempt < CONNECT_ATTEMPTS; attempt++)
+    {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if(fd < 0)
+            return -1;
+        if(connect(fd, (sockaddr *)&address, sizeof(address)) == 0)
+            return fd;
+
+        close(fd);
+        usleep(100000);
+    }
+
+    return -1;
+}
+
+/**
+ * Sends one request and reads the one-line reply.
+ * @return The reply without its newline, or an empty string if the server
+ *  closed the connection.
+ */
+static string request(int fd, const string &line)
+{
+    string data = line + "\n";
+    size_t sent = 0;
+    while(sent < data.size())
+    {
+        ssize_t count = send(fd, data.data() + sent, data.size() - sent,
+                             MSG_NOSIGNAL);
+        if(count < 0 && errno == EINTR)
+            continue;
+        if(count <= 0)
+            return "";
+        sent += count;
+    }
+
+    string result;
+    char c;
+    while(true)
+    {
+        ssize_t count = recv(fd, &c, 1, 0);
+        if(count < 0 && errno == EINTR)
+            continue;
+        if(count <= 0 || c == '\n')
+            break;
+        result += c;
+    }
+
+    return result;
+}
+
+/**
+ * Sends the requests being tested and checks each reply.
+ * @param fd The session quizzing the good profile
+ * @param otherFd A second session, which tries the corrupt profile
+ */
+static void runChecks(int fd, int otherFd)
+{
+    check("LOGIN", request(fd, "LOGIN\t" TEST_USERNAME),
+          "OK\tQuiz Server Test");
+
+    check("START with an unknown language",
+          request(fd, "START\tEnglish\tKlingon"), "ERR\tUnknown language.");
+
+    check("START on an empty list", request(fd, "START\tEnglish\tFrench"),
+          "OK");
+    check("ANSWER on an empty list", request(fd, "ANSWER\tchien"),
+          "ERR\tNo prompt.");
+    check("NEXT on an empty list", request(fd, "NEXT"), "OK\tDONE");
+    check("ANSWER after the last prompt", request(fd, "ANSWER\tchien"),
+          "ERR\tNo prompt.");
+
+    check("START", request(fd, "START\tEnglish\tGerman"), "OK");
+    check("ANSWER before NEXT", request(fd, "ANSWER\tHund"),
+          "ERR\tNo prompt.");
+    check("SCORE before NEXT", request(fd, "SCORE"), "OK\t0\t0");
+    check("NEXT", request(fd, "NEXT"), "OK\tdog");
+    check("ANSWER after NEXT", request(fd, "ANSWER\tHund"),
+          "OK\tcorrect\tHund");
+    check("ANSWER twice", request(fd, "ANSWER\tHund"), "ERR\tNo prompt.");
+
+    check("LOGIN as a corrupt profile",
+          request(otherFd, "LOGIN\t" CORRUPT_USERNAME),
+          "ERR\tInvalid profile.");
+    check("START after a failed LOGIN",
+          request(otherFd, "START\tEnglish\tGerman"), "ERR\tNot logged in.");
+    check("LOGIN as a corrupt profile again",
+          request(otherFd, "LOGIN\t" CORRUPT_USERNAME),
+          "ERR\tInvalid profile.");
+
+    check("SCORE", request(fd, "SCORE"), "OK\t1\t0");
+
+    char records[16];
+    sprintf(records, "%d", countJournalRecords());
+    check("Answers journaled", records, "1");
+
+    check("LOGOUT", request(fd, "LOGOUT"), "OK");
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc != 2)
+    {
+        cerr << "Usage: quizservertest <quizserver>" << endl;
+        return 2;
+    }
+
+    if(!writeProfiles())
+    {
+        cerr << "Could not write the test profiles." << endl;
+        removeProfiles();
+        return 2;
+    }
+
+    char socketPath[64];
+    sprintf(socketPath, "/tmp/quizservertest.%d.sock", (int)getpid());
+
+    pid_t server = fork();
+    if(server < 0)
+    {
+        cerr << "Could not start the server." << endl;
+        removeProfiles();
+        return 2;
+    }
+    if(server == 0)
+    {
+        execl(argv[1], argv[1], "-s", socketPath, "-j", "2", (char *)NULL);
+        _exit(127);
+    }
+
+    int fd = connectToServer(socketPath);
+    int otherFd = connectToServer(socketPath);
+    if(fd < 0 || otherFd < 0)
+    {
+        cout << "FAIL  The server did not start listening." << endl;
+        numFailed++;
+    }
+    else
+        runChecks(fd, otherFd);
+
+    if(fd >= 0)
+        close(fd);
+    if(otherFd >= 0)
+        close(otherFd);
+
+    kill(server, SIGTERM);
+    waitpid(server, NULL, 0);
+    unlink(socketPath);
+    removeProfiles();
+
+    return numFailed > 0 ? 1 : 0;
+}
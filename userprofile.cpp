@@ -6,20 +6,56 @@
  * Stores all the data associated with a given user.
  * Contains load and save functions to store this information in a file and to
  * retrieve the information.
+ *
+ * Profiles can be stored in two formats. The text format is easy to read and
+ * edit, and is used for importing and exporting profiles. The binary format
+ * is what ProfileManager uses day to day, because it loads with almost no
+ * parsing. All values are written in the host's byte order:
+ *
+ *   - Header: the four bytes of PROFILE_MAGIC, then uint32 version and
+ *     uint32 section count, then the username and full name.
+ *   - Table of contents: for each language pair, lang1, lang2, uint32
+ *     homeLang and the uint64 offset of its section from the start of the
+ *     file.
+ *   - One section per language pair: uint32 connection count n, followed by
+ *     the columns
+ *       - uint32 offsets[2n + 1]: word1 of connection i is the text between
+ *         offsets[2i] and offsets[2i + 1] in the word data, and word2 is the
+ *         text between offsets[2i + 1] and offsets[2i + 2],
+ *       - int32 proficiency[n],
+ *       - int64 lastQuizzed[n],
+ *       - the word data itself, offsets[2n] bytes long.
+ *
+ * Strings outside the word data are stored as a uint32 length followed by
+ * their bytes.
+ *
+ * Loading a binary profile only reads the header and table of contents. The
+ * file stays mapped, and each language pair's master list is loaded the
+ * first time it is asked for, so logging in costs the same however many
+ * language pairs a user has. Version 1 files have no table of contents; the
+ * language pair is written at the start of each section instead, and they
+ * are loaded in full.
  */
 
 #include "userprofile.hpp"
+#include "profilesnapshot.hpp"
+#include "binaryreader.hpp"
+
+#include <cstring>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 
 using namespace std;
 using namespace boost;
 
-// Necessary for use in the BOOST_FOREACH macro.
-typedef pair<LanguagePair, MasterList> pair_t;
-
 UserProfile::UserProfile()
 {
     username = "";
     fullName = "";
+    wordPool.reset(new WordPool);
+    numPending = 0;
     valid = false;
 }
 
@@ -31,6 +67,8 @@ UserProfile::UserProfile(string newUsername)
 {
     username = newUsername;
     fullName = "";
+    wordPool.reset(new WordPool);
+    numPending = 0;
     valid = true;
 }
 
@@ -42,6 +80,8 @@ UserProfile::UserProfile(string newUsername, string newFullName)
 {
     username = newUsername;
     fullName = newFullName;
+    wordPool.reset(new WordPool);
+    numPending = 0;
     valid = true;
 }
 
@@ -49,22 +89,33 @@ UserProfile::UserProfile(string newUsername, string newFullName)
 /**
  * Returns the user's master list for the specified languages.
  * @param languages The language pair to be found.
- * @return The MasterList containing all words in those languages.
+ * @return The MasterList containing all words in those languages, or NULL
+ *  if the user has no list for them. If the list is still in the profile
+ *  file, it is loaded first.
  * @todo Make sure it doesn't matter which language is home: we should only
  *  find one set of languages. This should be taken care of already though.
  */
-MasterList* UserProfile::getMasterListForLanguages(LanguagePair languages)
+MasterList* UserProfile::getMasterListForLanguages(const LanguagePair &languages)
 {
     if(!valid)
         throw new InvalidUserProfileException;
 
-    return &((*(masterListMap.find(languages))).second);
+    int section = findSection(languages);
+    if(section == NO_SECTION)
+        return NULL;
+
+    // The list may not have been loaded from the profile file yet
+    if(sections[section].state == SECTION_PENDING &&
+       !loadPendingSection(section))
+        return NULL;
+
+    return &masterLists[section];
 }
 
 
 /**
  * Saves all information of a user profile in text format to the specified
- * profile file.
+ * profile file. The old file is only replaced once the new one is complete.
  * @param filename The full path and name of the file
  * @return True if the save was successful, false otherwise.
  * @todo Don't save as plaintext: encrypt somehow so users don't game the
@@ -75,37 +126,10 @@ bool UserProfile::saveProfile(string filename)
     if(!valid)
         throw new InvalidUserProfileException;
 
-    ofstream userFile;
-    userFile.open(filename.c_str(), ofstream::out);
-
-    // Check for failed file open
-    if(!userFile.is_open())
-        return false;
-
-    userFile << username << endl;
-    userFile << fullName << endl;
-
-    BOOST_FOREACH(pair_t pair, masterListMap)
-    {
-        userFile << "---\n";
-
-        LanguagePair lp = pair.first;
-        MasterList list = pair.second;
-
-        userFile << lp.lang1 << "\t" << lp.lang2 << "\t"
-                << lp.homeLang << endl;
-
-        std::list<Connection>::iterator itr;
-        for(itr = list.connList.begin(); itr != list.connList.end(); itr++)
-        {
-            Connection conn = *itr;
-            userFile << conn.exportToLine() << endl;
-        }
-    }
-
-    userFile.close();
+    // Lists are only written as text once they have been loaded
+    loadAllSections();
 
-    return true;
+    return snapshot()->saveProfile(filename);
 }
 
 
@@ -147,8 +171,10 @@ bool UserProfile::loadProfile(string filename)
     getline(userFile, line);
 
     // Clear out any masterLists in case load is called after some
-    // other initialization.
-    masterListMap.clear();
+    // other initialization, and start a fresh pool for their words.
+    clearSections();
+    profileData.reset();
+    wordPool.reset(new WordPool);
 
     // Loop to load a master list for each language pair
     while(userFile.good())
@@ -166,30 +192,29 @@ bool UserProfile::loadProfile(string filename)
         getline(userFile, line);
 
         // Load the language pair
-        LanguagePair *languages = new LanguagePair;
+        LanguagePair languages;
         int status;
 
-        if(!languages->loadFromLine(line, &status))
+        if(!languages.loadFromLine(line, &status))
         {
             cout << "Problem loading language pair." << endl;
-            free(languages);
             continue;
         }
 
-        if(masterListMap.find(*languages) != masterListMap.end())
+        if(findSection(languages) != NO_SECTION)
         {
             cout << "Duplicate languages list." << endl;
-            free(languages);
             continue;
         }
 
         /* Essentially undoes the alphabetical sorting. This is necessary for
            the moment: adding connections needs the languages unsorted again,
            and the connections will sort themselves upon construction. */
-        string myLang1 = (status == 0) ? languages->lang1 : languages->lang2;
-        string myLang2 = (status == 0) ? languages->lang2 : languages->lang1;
+        string myLang1 = (status == 0) ? languages.lang1 : languages.lang2;
+        string myLang2 = (status == 0) ? languages.lang2 : languages.lang1;
 
-        MasterList *mList = new MasterList(*languages);
+        // Built in place, so the connections are not copied afterwards
+        MasterList &mList = addSection(languages, SECTION_LOADED, 0);
 
         // Fill the master list with connections
         while(userFile.good())
@@ -199,31 +224,522 @@ bool UserProfile::loadProfile(string filename)
             if(line.compare("---") == 0 || line.compare("\n") == 0 || line.empty())
                 break;
 
-            Connection *conn = new Connection;
+            Connection conn;
 
             // Add the connection to the list if the connection loaded.
             //! @todo Maintain a list of failed loads and print error reports.
-            if(conn->loadFromLine(line, myLang1, myLang2))
+            if(conn.loadFromLine(line, myLang1, myLang2, *wordPool))
+                mList.addPooledConnection(conn);
+            else
+                cout << "Connection misload." << endl;
+        }
+    }
+
+    userFile.close();
+
+    valid = true;
+    return true;
+}
+
+
+/**
+ * Saves all information of a user profile to the specified file in the
+ * binary format described at the top of this file. Master lists which have
+ * not been loaded yet are copied from the old file as they are, and the old
+ * file is only replaced once the new one is complete.
+ * @param filename The full path and name of the file
+ * @return True if the save was successful, false otherwise.
+ */
+bool UserProfile::saveBinaryProfile(string filename)
+{
+    if(!valid)
+        throw new InvalidUserProfileException;
+
+    return snapshot()->saveBinaryProfile(filename);
+}
+
+
+/**
+ * Takes a snapshot of the profile which can be saved on another thread while
+ * this profile keeps changing. No rows are copied, so the snapshot is cheap
+ * however large the lists are. Master lists which have not been loaded are
+ * left in the mapped profile file, for the snapshot to copy as they are;
+ * only a list holding answers replayed from the journal is loaded first, so
+ * that the answers are saved with it.
+ */
+boost::shared_ptr<const ProfileSnapshot> UserProfile::snapshot()
+{
+    if(!valid)
+        throw new InvalidUserProfileException;
+
+    boost::shared_ptr<ProfileSnapshot> frozen(
+            new ProfileSnapshot(username, fullName, wordPool));
+
+    // Loading the last pending list unmaps the file, so hold on to it here
+    boost::shared_ptr<interprocess::mapped_region> file = profileData;
+
+    for(size_t section = 0; section < sections.size(); section++)
+    {
+        ProfileSection &current = sections[section];
+
+        if(current.state == SECTION_PENDING && !current.journaled.empty())
+            loadPendingSection(section);
+
+        if(current.state == SECTION_PENDING)
+        {
+            const char *data;
+            size_t size;
+
+            // A list which is cut short is dropped, as loading it would
+            if(pendingSectionData(section, data, size))
+                frozen->addRawSection(current.languages, file, data, size);
+            else
+                loadPendingSection(section);
+        }
+
+        if(current.state == SECTION_LOADED)
+            frozen->addSection(current.languages,
+                               masterLists[section].connections);
+    }
+
+    return frozen;
+}
+
+
+/**
+ * Sets the statistics of the word an answer from the journal was for.
+ * @return False if the list has no such word
+ */
+static bool applyAnswer(MasterList &mList, const JournaledAnswer &answer)
+{
+    size_t row = mList.findConnection(answer.word1, answer.word2);
+    if(row == QuizList::npos)
+        return false;
+
+    mList.connections.setUserProficiency(row, answer.proficiency);
+    mList.connections.setLastQuizzed(row, answer.lastQuizzed);
+    return true;
+}
+
+
+/**
+ * Applies an answer replayed from the journal. A list which is still in the
+ * profile file is not loaded for it; the answer is kept with the list and
+ * applied when the list is first requested.
+ * @param languages The languages of the list the answer was for
+ * @param answer The word and its new statistics
+ * @return False if the profile has no such list, or the list no such word
+ */
+bool UserProfile::applyJournaledAnswer(const LanguagePair &languages,
+                                       const JournaledAnswer &answer)
+{
+    if(!valid)
+        throw new InvalidUserProfileException;
+
+    int section = findSection(languages);
+    if(section == NO_SECTION)
+        return false;
+
+    if(sections[section].state == SECTION_PENDING)
+    {
+        sections[section].journaled.push_back(answer);
+        return true;
+    }
+
+    return applyAnswer(masterLists[section], answer);
+}
+
+
+/**
+ * Steps over one binary section without reading its connections.
+ * @param reader Positioned at the section's connection count
+ * @param sectionEnd Set to the end of the section
+ * @return False if the section is truncated
+ */
+static bool skipSection(BinaryReader &reader, const char *&sectionEnd)
+{
+    uint32_t count;
+    const char *offsetBlock, *rowBlock, *words;
+
+    if(!reader.read(count))
+        return false;
+
+    if(!reader.readBlock((2 * (size_t) count + 1) * sizeof(uint32_t),
+                         offsetBlock) ||
+       !reader.readBlock(count * (sizeof(int32_t) + sizeof(int64_t)),
+                         rowBlock))
+        return false;
+
+    uint32_t wordsSize;
+    memcpy(&wordsSize, offsetBlock + 2 * count * sizeof(uint32_t),
+           sizeof(uint32_t));
+    if(!reader.readBlock(wordsSize, words))
+        return false;
+
+    sectionEnd = words + wordsSize;
+    return true;
+}
+
+
+/**
+ * Reads the connections of one binary section into a master list.
+ * @param reader Positioned at the section's connection count
+ * @param mList The list to fill, already set to the section's languages
+ * @param pool The pool to intern the words into
+ * @return False if the section is truncated or corrupt
+ */
+static bool readSection(BinaryReader &reader, MasterList &mList,
+                        WordPool &pool)
+{
+    uint32_t count;
+    const char *offsetBlock, *proficiencyBlock, *quizzedBlock, *words;
+
+    if(!reader.read(count))
+        return false;
+
+    if(!reader.readBlock((2 * (size_t) count + 1) * sizeof(uint32_t),
+                         offsetBlock) ||
+       !reader.readBlock(count * sizeof(int32_t), proficiencyBlock) ||
+       !reader.readBlock(count * sizeof(int64_t), quizzedBlock))
+        return false;
+
+    uint32_t wordsSize;
+    memcpy(&wordsSize, offsetBlock + 2 * count * sizeof(uint32_t),
+           sizeof(uint32_t));
+    if(!reader.readBlock(wordsSize, words))
+        return false;
+
+    uint32_t previous = 0;
+    for(uint32_t i = 0; i < count; i++)
+    {
+        uint32_t offset[3];
+        int32_t proficiency;
+        int64_t lastQuizzed;
+
+        memcpy(offset, offsetBlock + 2 * i * sizeof(uint32_t),
+               sizeof(offset));
+        memcpy(&proficiency, proficiencyBlock + i * sizeof(int32_t),
+               sizeof(int32_t));
+        memcpy(&lastQuizzed, quizzedBlock + i * sizeof(int64_t),
+               sizeof(int64_t));
+
+        // Offsets must never run backwards or past the word data
+        if(offset[0] < previous || offset[1] < offset[0] ||
+           offset[2] < offset[1] || offset[2] > wordsSize)
+            return false;
+        previous = offset[1];
+
+        Connection conn(pool, mList.lang1, mList.lang2,
+                        string_ref(words + offset[0], offset[1] - offset[0]),
+                        string_ref(words + offset[1], offset[2] - offset[1]));
+        conn.setUserProficiency(proficiency);
+        conn.setLastQuizzed((time_t) lastQuizzed);
+
+        mList.addPooledConnection(conn);
+    }
+
+    mList.listPos = 0;
+    return true;
+}
+
+
+/**
+ * Loads a user profile from a file in the binary format and sets the valid
+ * tag to true. Only the header and table of contents are read here; each
+ * master list is read from the mapped file when it is first requested.
+ * @param filename The file containing a binary UserProfile
+ * @return True if the load was successful, false otherwise.
+ */
+bool UserProfile::loadBinaryProfile(string filename)
+{
+    using namespace boost::interprocess;
+
+    boost::shared_ptr<mapped_region> region(new mapped_region);
+    try
+    {
+        file_mapping mapping(filename.c_str(), read_only);
+        mapped_region mapped(mapping, read_only);
+        region->swap(mapped);
+    }
+    catch(interprocess_exception &)
+    {
+        cout << "Failed file open." << endl;
+        return false;
+    }
+
+    const char *begin = (const char*) region->get_address();
+    BinaryReader reader(begin, begin + region->get_size());
+
+    const char *magic;
+    uint32_t version, sectionCount;
+
+    if(!reader.readBlock(4, magic) || memcmp(magic, PROFILE_MAGIC, 4) != 0)
+        return false;
+    if(!reader.read(version) || version < 1 || version > PROFILE_VERSION)
+        return false;
+    if(!reader.read(sectionCount))
+        return false;
+    if(!reader.readString(username) || !reader.readString(fullName))
+        return false;
+
+    // Clear out any masterLists in case load is called after some
+    // other initialization, and start a fresh pool for their words.
+    clearSections();
+    profileData.reset();
+    wordPool.reset(new WordPool);
+
+    for(uint32_t section = 0; section < sectionCount; section++)
+    {
+        string lang1, lang2;
+        uint32_t homeLang;
+
+        if(!reader.readString(lang1) || !reader.readString(lang2) ||
+           !reader.read(homeLang))
+            return false;
+
+        LanguagePair languages(lang1, lang2, homeLang);
+
+        if(version == 1)
+        {
+            // No table of contents: the section follows straight away, and
+            // is read even if it is a duplicate to get past it
+            if(findSection(languages) != NO_SECTION)
             {
-                mList->connList.push_back(*conn);
+                cout << "Duplicate languages list." << endl;
+
+                MasterList duplicate(languages, wordPool);
+                if(!readSection(reader, duplicate, *wordPool))
+                    return false;
             }
             else
             {
-                cout << "Connection misload." << endl;
-                free(conn);
+                MasterList &mList = addSection(languages, SECTION_LOADED, 0);
+                if(!readSection(reader, mList, *wordPool))
+                    return false;
             }
         }
+        else
+        {
+            uint64_t offset;
+            if(!reader.read(offset) || offset > region->get_size())
+                return false;
 
-        masterListMap.insert(make_pair(languages, mList));
+            if(findSection(languages) != NO_SECTION)
+                cout << "Duplicate languages list." << endl;
+            else
+                addSection(languages, SECTION_PENDING, offset);
+        }
     }
 
-    userFile.close();
+    // Keep the file mapped until every section has been loaded
+    if(numPending != 0)
+        profileData = region;
 
     valid = true;
     return true;
 }
 
 
+/**
+ * Finds the section holding the user's list for a pair of languages,
+ * without hashing or comparing any language names.
+ * @return The index of the section, or NO_SECTION if there is none.
+ */
+int UserProfile::findSection(const LanguagePair &languages) const
+{
+    if(languages.lang1Id >= sectionIndex.size())
+        return NO_SECTION;
+
+    const vector<int> &row = sectionIndex[languages.lang1Id];
+    if(languages.lang2Id >= row.size())
+        return NO_SECTION;
+
+    return row[languages.lang2Id];
+}
+
+
+/**
+ * Adds an empty master list for a pair of languages the profile does not
+ * have a list for yet.
+ * @param languages The languages of the list
+ * @param state SECTION_LOADED, or SECTION_PENDING if the list is still in
+ *  the mapped profile file
+ * @param offset Where a pending list starts in the profile file
+ * @return The new list, which stays at the same address from now on
+ */
+MasterList& UserProfile::addSection(const LanguagePair &languages, int state,
+                                    uint64_t offset)
+{
+    ProfileSection section;
+    section.languages = languages;
+    section.state = state;
+    section.offset = offset;
+
+    if(languages.lang1Id >= sectionIndex.size())
+        sectionIndex.resize(languages.lang1Id + 1);
+
+    vector<int> &row = sectionIndex[languages.lang1Id];
+    if(languages.lang2Id >= row.size())
+        row.resize(languages.lang2Id + 1, NO_SECTION);
+
+    row[languages.lang2Id] = sections.size();
+    sections.push_back(section);
+    masterLists.push_back(MasterList(languages, wordPool));
+
+    if(state == SECTION_PENDING)
+        numPending++;
+
+    return masterLists.back();
+}
+
+
+/**
+ * Removes every master list from the profile.
+ */
+void UserProfile::clearSections()
+{
+    masterLists.clear();
+    sections.clear();
+    sectionIndex.clear();
+    numPending = 0;
+}
+
+
+/**
+ * Loads one master list from the mapped profile file. A list which cannot
+ * be read is dropped from the profile.
+ * @param section The index of a SECTION_PENDING section
+ * @return True if the list was loaded, false if it could not be read.
+ */
+bool UserProfile::loadPendingSection(int section)
+{
+    ProfileSection &pending = sections[section];
+    MasterList &mList = masterLists[section];
+
+    const char *begin = (const char*) profileData->get_address();
+    BinaryReader reader(begin + pending.offset,
+                        begin + profileData->get_size());
+
+    bool loaded = readSection(reader, mList, *wordPool);
+    if(loaded)
+    {
+        pending.state = SECTION_LOADED;
+
+        // Catch up on the answers the journal held for the list
+        for(size_t i = 0; i < pending.journaled.size(); i++)
+            applyAnswer(mList, pending.journaled[i]);
+    }
+    else
+    {
+        cout << "Problem loading language pair." << endl;
+        pending.state = SECTION_FAILED;
+        mList = MasterList(pending.languages, wordPool);
+        sectionIndex[pending.languages.lang1Id][pending.languages.lang2Id] =
+                NO_SECTION;
+    }
+
+    vector<JournaledAnswer>().swap(pending.journaled);
+
+    numPending--;
+    if(numPending == 0)
+        profileData.reset();
+
+    return loaded;
+}
+
+
+/**
+ * Finds a master list which is still waiting in the mapped profile file.
+ * @param section The index of a SECTION_PENDING section
+ * @param data Set to where the section starts in the file
+ * @param size Set to the length of the section
+ * @return False if the section is cut short by the end of the file
+ */
+bool UserProfile::pendingSectionData(int section, const char *&data,
+                                     size_t &size)
+{
+    const char *begin = (const char*) profileData->get_address();
+    const char *end = begin + profileData->get_size();
+    const char *sectionEnd;
+
+    data = begin + sections[section].offset;
+    BinaryReader reader(data, end);
+    if(!skipSection(reader, sectionEnd))
+        return false;
+
+    size = sectionEnd - data;
+    return true;
+}
+
+
+/**
+ * Loads every master list which is still waiting in the profile file. Needed
+ * before the whole profile is written as text.
+ */
+void UserProfile::loadAllSections()
+{
+    for(size_t section = 0; section < sections.size(); section++)
+    {
+        if(sections[section].state == SECTION_PENDING)
+            loadPendingSection(section);
+    }
+}
+
+
+/**
+ * Lists every language pair the user has a master list for, without loading
+ * any of the lists.
+ */
+vector<LanguagePair> UserProfile::getLanguagePairs()
+{
+    vector<LanguagePair> pairs;
+
+    for(size_t section = 0; section < sections.size(); section++)
+    {
+        if(sections[section].state != SECTION_FAILED)
+            pairs.push_back(sections[section].languages);
+    }
+
+    return pairs;
+}
+
+
+/**
+ * Estimates the memory the profile takes: its words, its loaded lists, and
+ * the mapped binary file still holding sections which have not been loaded.
+ */
+size_t UserProfile::bytesUsed()
+{
+    return wordPool->bytesUsed() + listBytesUsed();
+}
+
+
+/**
+ * Estimates the memory the profile takes apart from its word pool, which is
+ * shared with copies of the profile and keeps growing as they load lists.
+ */
+size_t UserProfile::listBytesUsed()
+{
+    size_t bytes = sizeof(*this);
+
+    for(size_t section = 0; section < sections.size(); section++)
+    {
+        bytes += sizeof(ProfileSection) +
+                 sections[section].journaled.capacity() *
+                 sizeof(JournaledAnswer);
+        if(sections[section].state == SECTION_LOADED)
+            bytes += masterLists[section].bytesUsed();
+        else
+            bytes += sizeof(MasterList);
+    }
+
+    if(profileData)
+        bytes += profileData->get_size();
+
+    return bytes;
+}
+
+
 string UserProfile::getUsername()
 {
     return username;
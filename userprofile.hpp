@@ -9,42 +9,59 @@
 
 #include <iostream>
 #include <fstream>
+#include <deque>
+#include <vector>
 
 #include "connection.hpp"
+#include "casefold.hpp"
 #include "quizlist.hpp"
 #include "languagepair.hpp"
+#include "wordpool.hpp"
+#include "profilesnapshot.hpp"
 
 #include <boost/config.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/foreach.hpp>
-#include <boost/tokenizer.hpp>
-#include <boost/unordered_map.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 
-//! @todo Might want to change this later, don't define my own functions
-//! @todo Or just make this implementation faster.
-//! Note that I don't check or care about homeLang here.
-struct ihash
-    : std::unary_function<LanguagePair, std::size_t>
+//! Marks the start of a binary profile file.
+#define PROFILE_MAGIC "WQPF"
+//! The version of the binary profile format written by saveBinaryProfile.
+#define PROFILE_VERSION 2
+
+//! Returned by findSection when the user has no list for the languages.
+#define NO_SECTION -1
+
+// The states of a section of a profile
+#define SECTION_LOADED 0
+#define SECTION_PENDING 1
+#define SECTION_FAILED 2
+
+/**
+ * An answer recorded in a profile's journal: the new statistics of one word.
+ */
+struct JournaledAnswer
 {
-    std::size_t operator()(LanguagePair const& l) const
-    {
-        std::stringstream concat;
-        concat << l.lang1 << "\t" << l.lang2;
-        std::size_t seed = 0;
-        boost::hash_combine( seed, concat.str() );
-        return seed;
-    }
+    std::string word1;
+    std::string word2;
+    int proficiency;
+    time_t lastQuizzed;
 };
 
-//! Also doesn't care about homeLang
-struct iequal_to
-    : std::binary_function<LanguagePair, LanguagePair, bool>
+/**
+ * One master list of a profile, which may still be in the profile file.
+ */
+struct ProfileSection
 {
-    bool operator()(LanguagePair const& x, LanguagePair const& y) const
-    {
-        return ( boost::iequals(x.lang1, y.lang1) &&
-                 boost::iequals(x.lang2, y.lang2));
-    }
+    LanguagePair languages;
+    //! SECTION_LOADED, SECTION_PENDING or SECTION_FAILED
+    int state;
+    //! Where the list starts in the mapped profile file, while pending
+    boost::uint64_t offset;
+    //! Answers from the journal for the list, applied once it is loaded
+    std::vector<JournaledAnswer> journaled;
 };
 
 class UserProfile
@@ -54,20 +71,51 @@ std::string fullName;
 
 bool valid;
 
-boost::unordered_map<LanguagePair, MasterList, ihash, iequal_to> masterListMap;
-boost::unordered_map<LanguagePair, MasterList, ihash, iequal_to>::iterator mItr;
+//! Stores every word of every master list in the profile exactly once.
+boost::shared_ptr<WordPool> wordPool;
+
+//! Every master list of the profile, loaded or not, in the order they were
+//! added. A deque, so that lists never move once they have been handed out.
+std::deque<MasterList> masterLists;
+//! The languages and state of the list at the same index in masterLists.
+std::vector<ProfileSection> sections;
+//! The index in sections of each pair of languages, or NO_SECTION, indexed
+//! by the pair's lang1Id and then its lang2Id.
+std::vector<std::vector<int> > sectionIndex;
+//! How many sections are SECTION_PENDING.
+size_t numPending;
+
+//! The mapped binary profile file, kept while sections are pending.
+boost::shared_ptr<boost::interprocess::mapped_region> profileData;
 
 public:
     UserProfile();
     UserProfile(std::string newUsername);
     UserProfile(std::string newUsername, std::string newFullName);
-    MasterList* getMasterListForLanguages(LanguagePair languages);
+    MasterList* getMasterListForLanguages(const LanguagePair &languages);
     bool saveProfile(std::string filename);
     bool loadProfile(std::string filename);
+    bool saveBinaryProfile(std::string filename);
+    bool loadBinaryProfile(std::string filename);
+    boost::shared_ptr<const ProfileSnapshot> snapshot();
+    bool applyJournaledAnswer(const LanguagePair &languages,
+                              const JournaledAnswer &answer);
+    void loadAllSections();
+    std::vector<LanguagePair> getLanguagePairs();
+    size_t bytesUsed();
+    size_t listBytesUsed();
 
     std::string getUsername();
     std::string getFullName();
     bool isValid();
+
+private:
+    int findSection(const LanguagePair &languages) const;
+    MasterList& addSection(const LanguagePair &languages, int state,
+                           boost::uint64_t offset);
+    void clearSections();
+    bool loadPendingSection(int section);
+    bool pendingSectionData(int section, const char *&data, size_t &size);
 };
 
 #endif // USERPROFILE_H
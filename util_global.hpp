@@ -1,8 +1,6 @@
 #ifndef SYSTEM_VARS_H
 #define SYSTEM_VARS_H
 
-#include <QFont>
-
 #define WORDQUIZ_DIR "/home/azirbel/.wordQuiz/"
 #define STD_WIDTH 500
 #define STD_HEIGHT 400
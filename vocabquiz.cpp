@@ -12,6 +12,9 @@
  */
 
 #include "vocabquiz.hpp"
+#include "answerjournal.hpp"
+#include "casefold.hpp"
+#include "editdistance.hpp"
 
 using namespace std;
 using namespace boost;
@@ -23,7 +26,12 @@ FillInVocabQuiz::FillInVocabQuiz(QuizList *myList)
 {
     direction = STANDARD;
     isCaseSensitive = true;
+    maxTypos = 0;
     list = myList;
+    lang1 = myList->lang1;
+    lang2 = myList->lang2;
+    journal = NULL;
+    curRow = QuizList::npos;
     resetQuiz();
 }
 
@@ -83,6 +91,39 @@ bool VocabQuiz::getCaseSensitive()
 }
 
 
+/**
+ * Sets how many typos are forgiven in an answer. A typo is one character
+ * inserted, deleted or replaced, so an answer is still correct if it is at
+ * most this many typos away from any of the prompt's translations.
+ * @param newMaxTypos The number of typos to forgive, or 0 for exact answers.
+ */
+void VocabQuiz::setMaxTypos(int newMaxTypos)
+{
+    maxTypos = newMaxTypos;
+}
+
+
+/**
+ * Returns how many typos are forgiven in an answer.
+ * @return The number of typos forgiven, 0 if answers must be exact.
+ */
+int VocabQuiz::getMaxTypos()
+{
+    return maxTypos;
+}
+
+
+/**
+ * Sets the journal answers are recorded in, so that the new statistics of
+ * every word quizzed are saved as soon as it is answered.
+ * @param newJournal The profile's journal, or NULL to record nothing.
+ */
+void VocabQuiz::setJournal(AnswerJournal *newJournal)
+{
+    journal = newJournal;
+}
+
+
 /**
  * Accessor for number of correct answers so far.
  * @return Number of questions the user has answered correctly.
@@ -105,94 +146,149 @@ int VocabQuiz::getNumWrong()
 
 /**
  * Returns a new prompt for the next question, in the given direction
- * (STANDARD or REVERSE).  Prompts are guaranteed never to repeat throughout
- * the course of a test.
+ * (STANDARD or REVERSE).
  *
- * Grabs the current connection, and at the end of the method advances the
- * iterator.
- * @return The next randomly selected prompt word, or "" if out of words.
+ * Prompts are chosen by the quiz's scheduler: words which are due for review
+ * and least known come first, and a word which was just answered is moved
+ * back according to how well the user now knows it. A quiz lasts until as
+ * many prompts have been answered as there are words in the list; until the
+ * current prompt is answered, it is given again.
+ * @return The next prompt word, or "" if the quiz is over.
  */
 string FillInVocabQuiz::nextPrompt()
 {
-    //! @todo More input checks
-    /*if(*(list->listItr) == NULL)
-    {
-        return "";
-    }*/
-
-    if(list->listItr == (list->connList).end())
+    if(scheduler.empty() || numAsked >= scheduler.size())
     {
+        curRow = QuizList::npos;
         return "";
     }
 
-    //! @todo This is ugly and might not be correct. Change later.
-    curConn = &(*(list->listItr));
+    // The scheduler's handles are rows of the list. The top only changes
+    // once its word has been answered.
+    curRow = scheduler.top();
 
     if(direction == STANDARD)
-        return curConn->getWord1();
+        return list->connections.getWord1(curRow);
     else
-        return curConn->getWord2();
+        return list->connections.getWord2(curRow);
+}
+
 
-    (list->listItr)++;
+/**
+ * Whether a prompt is waiting for an answer. There is none before the first
+ * call to nextPrompt, once the prompt has been answered, and once the quiz
+ * is over.
+ * @return True if the current prompt may be answered
+ */
+bool FillInVocabQuiz::hasPrompt()
+{
+    return curRow != QuizList::npos;
 }
 
 
 /**
- * Returns a string representing the correct answer for a given prompt.
- * @param prompt The question word (from lang1 if direction is STANDARD)
+ * Returns a string representing the correct answer for the current prompt.
+ * Throws a NoPromptException if there is no prompt waiting for an answer.
  * @return A string representing the correct answer in the current direction.
  */
 string FillInVocabQuiz::getCorrectAnswer()
 {
+    if(!hasPrompt())
+        throw new NoPromptException;
+
     //! @todo return all possibilities
     if(direction == STANDARD)
-        return curConn->getWord2();
+        return list->connections.getWord2(curRow);
     else
-        return curConn->getWord1();
+        return list->connections.getWord1(curRow);
 }
 
 
+/**
+ * Checks an answer to the current prompt and returns whether the answer was
+ * correct in the loaded dictionary. Does not change quiz statistics. Throws
+ * a NoPromptException if there is no prompt waiting for an answer.
+ * @param answer The entered answer for the prompt
+ * @return True if the answer was correct, false otherwise
+ */
+bool FillInVocabQuiz::isCorrectAnswer(const string &answer)
+{
+    if(!hasPrompt())
+        throw new NoPromptException;
+
+    if(direction == STANDARD)
+        return isCorrectAnswer(list->connections.getWord1(curRow), answer);
+    else
+        return isCorrectAnswer(list->connections.getWord2(curRow), answer);
+}
+
 /**
  * Checks a prompt and answer and returns whether the answer was correct in the
- * loaded dictionary. Does not change quiz statistics.
+ * loaded dictionary. Does not change quiz statistics or depend on the current
+ * prompt, so it may be called from several threads at once as long as the
+ * list is not being changed. If typos are forgiven and the answer is not
+ * exactly right, it is compared against every translation of the prompt.
  * @param prompt The question word (from lang1 if direction is STANDARD)
  * @param answer The entered answer for the prompt
  * @return True if the answer was correct, false otherwise
  */
-bool FillInVocabQuiz::isCorrectAnswer(string answer)
+bool FillInVocabQuiz::isCorrectAnswer(const string &prompt,
+                                      const string &answer)
 {
-    Connection *inputConn;
-
+    bool exact;
     if(direction == STANDARD)
-        inputConn = new Connection(lang1, lang2, curConn->getWord1(), answer);
+        exact = list->containsWords(prompt, answer, isCaseSensitive);
     else
-        inputConn = new Connection(lang1, lang2, answer, curConn->getWord2());
+        exact = list->containsWords(answer, prompt, isCaseSensitive);
+
+    if(exact || maxTypos <= 0)
+        return exact;
 
-    if(list->contains(*inputConn, isCaseSensitive))
-        return true;
+    vector<const string*> translations;
+    list->findTranslations(prompt, direction == STANDARD, isCaseSensitive,
+                           translations);
+
+    // Case insensitive translations come back folded, so fold the answer too
+    TypoMatcher matcher(isCaseSensitive ? answer : foldCase(answer), maxTypos);
+    for(size_t i = 0; i < translations.size(); i++)
+    {
+        if(matcher.matches(*translations[i]))
+            return true;
+    }
 
     return false;
 }
 
 /**
- * Checks a prompt and answer and returns whether the answer was correct in the
- * loaded dictionary. Also keeps track of statistics - number right and wrong.
- * @param prompt The question word (from lang1 if direction is STANDARD)
+ * Checks an answer to the current prompt and returns whether the answer was
+ * correct in the loaded dictionary. Also keeps track of statistics - number
+ * right and wrong - and updates the word's proficiency and its place in the
+ * schedule, recording the change in the journal if there is one. The prompt
+ * is then answered, so the next one must be asked for. Throws a
+ * NoPromptException if there is no prompt waiting for an answer.
  * @param answer The entered answer for the prompt
  * @return True if the answer was correct, false otherwise
  */
-bool FillInVocabQuiz::checkAnswer(string answer)
+bool FillInVocabQuiz::checkAnswer(const string &answer)
 {
-    if(isCorrectAnswer(answer))
-    {
+    bool correct = isCorrectAnswer(answer);
+
+    if(correct)
         numRight++;
-        return true;
-    }
     else
-    {
         numWrong++;
-        return false;
+
+    scheduler.recordAnswer(curRow, correct, time(NULL));
+    numAsked++;
+
+    if(journal != NULL)
+    {
+        Connection conn = list->getConnection(curRow);
+        journal->record(conn);
     }
+
+    curRow = QuizList::npos;
+    return correct;
 }
 
 
@@ -201,12 +297,24 @@ bool FillInVocabQuiz::checkAnswer(string answer)
  */
 void VocabQuiz::resetQuiz()
 {
-    list->listItr = (list->connList).begin();
+    list->listPos = 0;
 
     numRight = 0;
     numWrong = 0;
 }
 
+/**
+ * Restarts the quiz, and schedules the list's words afresh.
+ */
+void FillInVocabQuiz::resetQuiz()
+{
+    VocabQuiz::resetQuiz();
+
+    scheduler.build(list->connections);
+    numAsked = 0;
+    curRow = QuizList::npos;
+}
+
 string FillInVocabQuiz::getQuizType()
 {
     return "FillInVocabQuiz";
@@ -2,12 +2,18 @@
 #define VOCABQUIZ_H
 
 #include "quizlist.hpp"
+#include "quizscheduler.hpp"
+
+class AnswerJournal;
 
 
 // Settings for this quiz
 #define STANDARD 1
 #define REVERSE 0
 
+//! How many typos are forgiven when typo tolerance is turned on.
+#define DEFAULT_MAX_TYPOS 1
+
 //! An abstract base class
 class VocabQuiz
 {
@@ -16,10 +22,13 @@ protected:
     std::string lang1;
     std::string lang2;
     QuizList *list;
-    Connection *curConn;
+    size_t curRow;          //!< The list row of the current prompt, or
+                            //!< QuizList::npos if none is waiting
     int direction;          //!< Stores direction of the quiz
     int isCaseSensitive;    //!< Whether to check for capitals or not
+    int maxTypos;           //!< How many typos an answer may have, if any
     int numRight, numWrong; //!< Store how the user is doing
+    AnswerJournal *journal; //!< Where answers are saved, if anywhere
 
 public:
     VocabQuiz() { }
@@ -30,6 +39,9 @@ public:
     void resetQuiz();
     void setCaseSensitive(bool newCaseSensitive);
     bool getCaseSensitive();
+    void setMaxTypos(int newMaxTypos);
+    int getMaxTypos();
+    void setJournal(AnswerJournal *newJournal);
     int getNumRight();
     int getNumWrong();
 
@@ -40,21 +52,32 @@ class FillInVocabQuiz : VocabQuiz
 {
 //!< @todo Variables like "caseSensitive" and other answer-checking options
 
+//! Picks the next prompt from the list, least known and longest due first.
+QuizScheduler scheduler;
+//! How many prompts have been answered since the quiz was reset.
+size_t numAsked;
+
 public:
     FillInVocabQuiz(QuizList *myList);
 
     std::string nextPrompt();
-    bool isCorrectAnswer(std::string answer);
-    bool checkAnswer(std::string answer);
+    bool hasPrompt();
+    bool isCorrectAnswer(const std::string &answer);
+    bool isCorrectAnswer(const std::string &prompt, const std::string &answer);
+    bool checkAnswer(const std::string &answer);
     std::string getCorrectAnswer();
 
     using VocabQuiz::setDirection;
     using VocabQuiz::getDirection;
     using VocabQuiz::setCaseSensitive;
     using VocabQuiz::getCaseSensitive;
+    using VocabQuiz::setMaxTypos;
+    using VocabQuiz::getMaxTypos;
+    using VocabQuiz::setJournal;
     using VocabQuiz::getNumRight;
     using VocabQuiz::getNumWrong;
-    using VocabQuiz::resetQuiz;
+
+    void resetQuiz();
 
     std::string getQuizType();
 };
@@ -0,0 +1,100 @@
+/**
+ * @file wordcompleter.cpp
+ * @brief Suggests words from a list which start with what has been typed.
+ * @author Alex Zirbel
+ *
+ * The words of one language of a list are collected once, sorted by their
+ * case-folded spelling. All the words starting with a prefix are then next
+ * to each other, so completing a prefix is one binary search followed by
+ * reading off as many words as are wanted, however large the list is.
+ */
+
+#include "wordcompleter.hpp"
+#include "casefold.hpp"
+
+#include <algorithm>
+
+using namespace std;
+
+/**
+ * Orders entries by folded word, then by word so that duplicates are
+ * adjacent, and compares entries against a folded prefix.
+ */
+struct EntryOrder
+{
+    typedef pair<const string*, const string*> Entry;
+
+    bool operator()(const Entry &a, const Entry &b) const
+    {
+        int order = a.first->compare(*b.first);
+        if(order != 0)
+            return order < 0;
+        return *a.second < *b.second;
+    }
+
+    bool operator()(const Entry &entry, const string &prefix) const
+    {
+        return *entry.first < prefix;
+    }
+};
+
+static bool sameWord(const pair<const string*, const string*> &a,
+                     const pair<const string*, const string*> &b)
+{
+    return a.second == b.second;
+}
+
+/**
+ * Collects and sorts the words to complete from.
+ * @param list The list to take the words from
+ * @param completeWord1 True to complete words in the first language of the
+ *        list, false for the second language
+ */
+WordCompleter::WordCompleter(QuizList *list, bool completeWord1)
+{
+    entries.reserve(list->connections.size());
+
+    for(size_t row = 0; row < list->connections.size(); row++)
+    {
+        const string *word = completeWord1 ?
+                             list->connections.getWord1Handle(row) :
+                             list->connections.getWord2Handle(row);
+        entries.push_back(Entry(list->wordPool->internFolded(*word), word));
+    }
+
+    sort(entries.begin(), entries.end(), EntryOrder());
+    entries.erase(unique(entries.begin(), entries.end(), sameWord),
+                  entries.end());
+}
+
+/**
+ * Returns how many distinct words there are to complete from.
+ */
+size_t WordCompleter::size() const
+{
+    return entries.size();
+}
+
+/**
+ * Finds the words starting with a prefix, ignoring case, in alphabetical
+ * order of their case-folded spelling.
+ * @param prefix What has been typed so far
+ * @param maxCompletions The most words to find
+ * @param completions Where the words found are appended
+ */
+void WordCompleter::complete(const string &prefix, size_t maxCompletions,
+                             vector<string> &completions) const
+{
+    string folded = foldCase(prefix);
+
+    vector<Entry>::const_iterator itr;
+    itr = lower_bound(entries.begin(), entries.end(), folded, EntryOrder());
+
+    for(size_t found = 0; itr != entries.end() && found < maxCompletions;
+        itr++, found++)
+    {
+        if(itr->first->compare(0, folded.size(), folded) != 0)
+            break;
+        completions.push_back(*itr->second);
+    }
+}
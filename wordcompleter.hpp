@@ -0,0 +1,35 @@
+/**
+ * @file wordcompleter.hpp
+ * @brief Header definitions for the WordCompleter class.
+ * @author Alex Zirbel
+ */
+
+#ifndef WORDCOMPLETER_H
+#define WORDCOMPLETER_H
+
+#include "quizlist.hpp"
+
+#include <string>
+#include <vector>
+#include <utility>
+
+//! How many completions are offered for one prefix by default.
+#define DEFAULT_MAX_COMPLETIONS 10
+
+class WordCompleter
+{
+//! A case-folded word and the word itself, both handles from the list's pool.
+typedef std::pair<const std::string*, const std::string*> Entry;
+
+//! Every distinct word in one language, sorted by the case-folded word.
+std::vector<Entry> entries;
+
+public:
+    WordCompleter(QuizList *list, bool completeWord1);
+
+    size_t size() const;
+    void complete(const std::string &prefix, size_t maxCompletions,
+                  std::vector<std::string> &completions) const;
+};
+
+#endif // WORDCOMPLETER_H
@@ -0,0 +1,224 @@
+/**
+ * @file wordpool.cpp
+ * @brief Stores each distinct word once and hands out handles to it.
+ * @author Alex Zirbel
+ *
+ * Connections refer to their languages and words through handles into a
+ * WordPool instead of owning their own copies. A user profile keeps one pool
+ * for all of its master lists, so a home-language word which appears in the
+ * English-German, English-French and English-Spanish lists is only stored
+ * once. Handles are plain pointers to the interned string and stay valid for
+ * as long as the pool is alive.
+ *
+ * The words are stored in an Arena owned by the pool, so a whole dictionary
+ * lives in a few large blocks instead of one heap allocation per word, and
+ * is released all at once when the last list using the pool goes away.
+ */
+
+#include "wordpool.hpp"
+#include "casefold.hpp"
+
+using namespace std;
+using boost::string_ref;
+
+// Words are hashed with FNV-1a, so that a view and a string hash alike and
+// a view can be hashed as if folded without building the folded copy.
+
+size_t WordHash::operator()(string_ref word) const
+{
+    size_t hash = 2166136261u;
+
+    for(size_t i = 0; i < word.size(); i++)
+    {
+        hash ^= (unsigned char) word[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+size_t FoldedWordHash::operator()(string_ref word) const
+{
+    size_t hash = 2166136261u;
+
+    for(size_t i = 0; i < word.size(); i++)
+    {
+        // Past ASCII, folding can change the length; fold the whole word
+        if(word[i] & 0x80)
+            return WordHash()(foldCase(word));
+
+        hash ^= (unsigned char) foldAsciiCase(word[i]);
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+bool WordEqual::operator()(string_ref word, const string &stored) const
+{
+    return word == string_ref(stored);
+}
+
+bool WordEqual::operator()(const string &stored, string_ref word) const
+{
+    return word == string_ref(stored);
+}
+
+bool FoldedWordEqual::operator()(string_ref word, const string &stored) const
+{
+    for(size_t i = 0; i < word.size(); i++)
+    {
+        if(word[i] & 0x80)
+            return foldCase(word) == stored;
+
+        if(i == stored.size() || foldAsciiCase(word[i]) != stored[i])
+            return false;
+    }
+
+    return word.size() == stored.size();
+}
+
+bool FoldedWordEqual::operator()(const string &stored, string_ref word) const
+{
+    return (*this)(word, stored);
+}
+
+
+WordPool::WordPool() :
+    words(0, WordHash(), equal_to<string>(), ArenaAllocator<string>(&arena))
+{
+    wordHeapBytes = 0;
+}
+
+
+/**
+ * Returns the handle for a word, adding the word to the pool if it has not
+ * been seen before. Only a new word is copied.
+ * @param word The word to intern
+ * @return A handle which compares equal for equal words from the same pool
+ */
+const string* WordPool::intern(string_ref word)
+{
+    const string *handle = find(word);
+
+    if(handle == NULL)
+        handle = insert(string(word.begin(), word.end()));
+
+    return handle;
+}
+
+
+/**
+ * Returns the handle for the case folded form of a word, adding the folded
+ * form to the pool if it has not been seen before.
+ * @param word The word to fold and intern
+ */
+const string* WordPool::internFolded(string_ref word)
+{
+    const string *handle = findFolded(word);
+
+    if(handle == NULL)
+        handle = insert(foldCase(word));
+
+    return handle;
+}
+
+
+/**
+ * Adds a word which is not yet in the pool, keeping count of the heap
+ * memory its characters take if they do not fit inside the string itself.
+ * @param word The word to add
+ * @return The new word's handle
+ */
+const string* WordPool::insert(const string &word)
+{
+    const string *handle = &(*(words.insert(word).first));
+
+    const char *characters = handle->data();
+    if(characters < (const char*) handle ||
+       characters >= (const char*) (handle + 1))
+        wordHeapBytes += heapBlockBytes(handle->capacity() + 1);
+
+    return handle;
+}
+
+
+/**
+ * Looks up a word without adding it to the pool or copying it.
+ * @param word The word to look for
+ * @return The word's handle, or NULL if the word is not in the pool
+ */
+const string* WordPool::find(string_ref word) const
+{
+    WordSet::const_iterator itr = words.find(word, WordHash(), WordEqual());
+
+    if(itr == words.end())
+        return NULL;
+
+    return &(*itr);
+}
+
+
+/**
+ * Looks up the case folded form of a word, without building it.
+ * @param word The word to fold and look for
+ * @return The handle of the folded word, or NULL if it is not in the pool
+ */
+const string* WordPool::findFolded(string_ref word) const
+{
+    WordSet::const_iterator itr = words.find(word, FoldedWordHash(),
+                                             FoldedWordEqual());
+
+    if(itr == words.end())
+        return NULL;
+
+    return &(*itr);
+}
+
+
+/**
+ * The number of distinct words stored in the pool.
+ */
+size_t WordPool::size() const
+{
+    return words.size();
+}
+
+
+/**
+ * The memory the pool takes up: the arena blocks holding the words, the
+ * set's bucket table once it is too large for the arena, and the characters
+ * of words too long to be stored inside their string.
+ */
+size_t WordPool::bytesUsed() const
+{
+    size_t bytes = arena.bytesReserved() + wordHeapBytes;
+
+    size_t bucketBytes = (words.bucket_count() + 1) * sizeof(void*);
+    if(bucketBytes > ARENA_LARGE_ALLOCATION)
+        bytes += heapBlockBytes(bucketBytes);
+
+    return bytes;
+}
+
+
+/**
+ * A handle to the empty string, used by blank connections which do not
+ * belong to any pool.
+ */
+const string* WordPool::emptyWord()
+{
+    static const string empty;
+    return &empty;
+}
+
+
+/**
+ * A process-wide pool for connections which are created on their own rather
+ * than loaded into a list or profile.
+ */
+WordPool& WordPool::sharedPool()
+{
+    static WordPool pool;
+    return pool;
+}
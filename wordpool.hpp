@@ -0,0 +1,75 @@
+/**
+ * @file wordpool.hpp
+ * @brief Header definitions for the WordPool class.
+ * @author Alex Zirbel
+ */
+
+#ifndef WORDPOOL_H
+#define WORDPOOL_H
+
+#include <string>
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_set.hpp>
+#include <boost/utility/string_ref.hpp>
+
+#include "arena.hpp"
+
+//! Hashes a word, giving the same value for a string and a view of it.
+struct WordHash
+{
+    std::size_t operator()(boost::string_ref word) const;
+};
+
+//! Hashes a view as if it had been case folded first.
+struct FoldedWordHash
+{
+    std::size_t operator()(boost::string_ref word) const;
+};
+
+//! Compares a view with a stored word.
+struct WordEqual
+{
+    bool operator()(boost::string_ref word, const std::string &stored) const;
+    bool operator()(const std::string &stored, boost::string_ref word) const;
+};
+
+//! Compares the case folded form of a view, as built by foldCase, with a
+//! stored word which is already folded.
+struct FoldedWordEqual
+{
+    bool operator()(boost::string_ref word, const std::string &stored) const;
+    bool operator()(const std::string &stored, boost::string_ref word) const;
+};
+
+class WordPool : boost::noncopyable
+{
+typedef boost::unordered_set<std::string, WordHash,
+        std::equal_to<std::string>, ArenaAllocator<std::string> > WordSet;
+
+//! Holds the nodes of the set below. Declared first, so that it outlives
+//! the set and is released in one go after it.
+Arena arena;
+//! Every distinct word in the pool. The set is node based, so the address
+//! of a stored word never changes once it has been interned.
+WordSet words;
+//! Heap memory held by words too long to be stored inside their string.
+size_t wordHeapBytes;
+
+public:
+    WordPool();
+
+    const std::string* intern(boost::string_ref word);
+    const std::string* internFolded(boost::string_ref word);
+    const std::string* find(boost::string_ref word) const;
+    const std::string* findFolded(boost::string_ref word) const;
+    size_t size() const;
+    size_t bytesUsed() const;
+
+    static const std::string* emptyWord();
+    static WordPool& sharedPool();
+
+private:
+    const std::string* insert(const std::string &word);
+};
+
+#endif // WORDPOOL_H